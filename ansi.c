@@ -0,0 +1,189 @@
+/**
+ * @file
+ *
+ * Diffing ANSI emitter. See ansi.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ansi.h"
+
+//------------------------------ Global Constants -----------------------------
+
+/**
+ * Runs of changed cells separated by at most this many unchanged cells are
+ * sent as one run. A cursor move is "\033[row;colH", several bytes, so
+ * resending a few unchanged cells is cheaper.
+ */
+static const int RUN_GAP = 5;
+
+/** Brackets a frame so terminals that support it draw it in one go. */
+const char ANSI_SYNC_BEGIN[] = "\033[?2026h";
+const char ANSI_SYNC_END[] = "\033[?2026l";
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Makes room for at least 'len' more bytes in a buffer, so that appending
+ * them won't allocate.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int outbuf_reserve(outbuf *ob, size_t len) {
+	size_t cap = ob->cap ? ob->cap : 4096;
+	char *p;
+
+	if (ob->cap - ob->len >= len)
+		return 0;
+	while (cap - ob->len < len)
+		cap *= 2;
+	if (!(p = realloc(ob->data, cap)))
+		return -1;
+	ob->data = p;
+	ob->cap = cap;
+	return 0;
+}
+
+/**
+ * Appends bytes to a buffer, growing it as needed. If memory runs out the
+ * bytes are dropped and the buffer is marked as failed.
+ */
+void outbuf_put(outbuf *ob, const void *data, size_t len) {
+	if (outbuf_reserve(ob, len)) {
+		ob->failed = 1;
+		return;
+	}
+	memcpy(ob->data + ob->len, data, len);
+	ob->len += len;
+}
+
+/**
+ * Appends a string to a buffer, without its terminating null.
+ */
+void outbuf_puts(outbuf *ob, const char *str) {
+	outbuf_put(ob, str, strlen(str));
+}
+
+/**
+ * Releases a buffer's memory and empties it.
+ */
+void outbuf_free(outbuf *ob) {
+	free(ob->data);
+	memset(ob, 0, sizeof(*ob));
+}
+
+/**
+ * Sets up an emitter for a terminal of the given size. The first flush
+ * clears the terminal and paints every cell.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int ansi_init(ansi_renderer *r, int rows, int cols) {
+	ansi_invalidate(r);
+	return cellbuf_init(&r->front, rows, cols);
+}
+
+/**
+ * Follows a change in the terminal size. The next flush repaints every
+ * cell.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int ansi_resize(ansi_renderer *r, int rows, int cols) {
+	ansi_invalidate(r);
+	return cellbuf_resize(&r->front, rows, cols);
+}
+
+/**
+ * Releases the emitter's copy of the screen.
+ */
+void ansi_free(ansi_renderer *r) {
+	cellbuf_free(&r->front);
+}
+
+/**
+ * Forgets what is on the terminal, so the next flush clears it and repaints
+ * every cell, e.g. after some output was lost.
+ */
+void ansi_invalidate(ansi_renderer *r) {
+	r->stale = 1;
+	r->cursor_row = -1;
+	r->cursor_col = -1;
+}
+
+/**
+ * Appends a run of cells, spelling out glyphs in UTF-8.
+ */
+static void put_cells(outbuf *out, const char *cells, int n) {
+	int i, start;
+
+	for (i = start = 0; i < n; i++) {
+		if ((unsigned char) cells[i] < GLYPH_FIRST)
+			continue;
+		outbuf_put(out, &cells[start], i - start);
+		outbuf_puts(out, cell_utf8(cells[i]));
+		start = i + 1;
+	}
+	outbuf_put(out, &cells[start], n - start);
+}
+
+/**
+ * Appends the escape sequences that bring the terminal from what it showed
+ * after the last flush to 'frame'. Changed cells are grouped into runs
+ * along each row the same way as in render_flush(), and the cursor is only
+ * moved where a run doesn't start where the last one left it.
+ *
+ * @param r
+ * @param frame Must be the same size the emitter was set up with.
+ * @param out Receives the escape sequences.
+ *
+ * @return Number of cells emitted.
+ */
+int ansi_flush(ansi_renderer *r, const cellbuf *frame, outbuf *out) {
+	char move[32];
+	int row, col, start, end, gap, sent = 0;
+
+	if (r->stale)
+		outbuf_puts(out, "\033[H\033[2J");
+
+	for (row = 0; row < frame->rows; row++) {
+		const char *next = &CELL(frame, row, 0);
+		char *shown = &CELL(&r->front, row, 0);
+
+		for (col = 0; col < frame->cols; col++) {
+			if (!r->stale && shown[col] == next[col])
+				continue;
+
+			// Extend the run over changed cells and short unchanged gaps.
+			start = col;
+			end = col + 1;
+			for (gap = 0, col++; col < frame->cols && gap <= RUN_GAP; col++) {
+				if (r->stale || shown[col] != next[col]) {
+					end = col + 1;
+					gap = 0;
+				}
+				else {
+					gap++;
+				}
+			}
+			col = end;
+
+			if (row != r->cursor_row || start != r->cursor_col) {
+				snprintf(move, sizeof(move), "\033[%d;%dH", row + 1, start + 1);
+				outbuf_puts(out, move);
+			}
+			put_cells(out, &next[start], end - start);
+			memcpy(&shown[start], &next[start], end - start);
+			sent += end - start;
+
+			// Terminals differ on where the cursor is after the last column.
+			r->cursor_row = end < frame->cols ? row : -1;
+			r->cursor_col = end < frame->cols ? end : -1;
+		}
+	}
+	r->stale = 0;
+
+	return sent;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file
+ *
+ * Lightweight ANSI terminal emitter: turns frames composed in a cellbuf
+ * into VT100 escape sequences in a byte buffer, for terminals that ncurses
+ * isn't driving, like the other end of a socket. Like render.h it remembers
+ * what the terminal shows and only emits the cells that changed.
+ */
+
+#ifndef ANSI_H
+#define ANSI_H
+
+#include <stddef.h>
+
+#include "cellbuf.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** A growable buffer of bytes waiting to be written somewhere. */
+typedef struct outbuf {
+	char *data;
+	size_t len, cap;
+
+	/* Nonzero if memory ran out and some bytes were dropped. */
+	int failed;
+} outbuf;
+
+/** Diffing ANSI front end for one terminal. */
+typedef struct ansi_renderer {
+	/* Copy of what the terminal is currently showing. */
+	cellbuf front;
+
+	/* Nonzero if 'front' can't be trusted and everything must be sent. */
+	int stale;
+
+	/* Where the terminal's cursor is, or -1 if unknown. */
+	int cursor_row, cursor_col;
+} ansi_renderer;
+
+//------------------------------ Global Constants -----------------------------
+
+extern const char ANSI_SYNC_BEGIN[];
+extern const char ANSI_SYNC_END[];
+
+//---------------------------------- Functions --------------------------------
+
+int outbuf_reserve(outbuf *ob, size_t len);
+void outbuf_put(outbuf *ob, const void *data, size_t len);
+void outbuf_puts(outbuf *ob, const char *str);
+void outbuf_free(outbuf *ob);
+
+int ansi_init(ansi_renderer *r, int rows, int cols);
+int ansi_resize(ansi_renderer *r, int rows, int cols);
+void ansi_free(ansi_renderer *r);
+void ansi_invalidate(ansi_renderer *r);
+int ansi_flush(ansi_renderer *r, const cellbuf *frame, outbuf *out);
+
+#endif
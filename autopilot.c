@@ -0,0 +1,211 @@
+/**
+ * @file
+ *
+ * Search-based autopilot. See autopilot.h.
+ */
+
+#include <stdlib.h>
+
+#include "autopilot.h"
+
+//------------------------------ Global Constants -----------------------------
+
+/**
+ * Slots probed for a state before giving up on memoizing it, so probes stay
+ * short even when the memo is crowded.
+ */
+static const int MAX_PROBES = 16;
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Sets up an autopilot that looks up to 'horizon' frames ahead. About two
+ * flap arcs (40 frames) is plenty to get through any opening.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int autopilot_init(autopilot *ap, int horizon) {
+	ap->horizon = horizon;
+	ap->round = 0;
+	ap->frame = -1;
+	ap->s = NULL;
+	ap->memo = calloc(AUTOPILOT_MEMO, sizeof(*ap->memo));
+	return ap->memo ? 0 : -1;
+}
+
+void autopilot_free(autopilot *ap) {
+	free(ap->memo);
+	ap->memo = NULL;
+}
+
+/**
+ * Finds the memo slot of a state: either the entry holding it or a free one
+ * where it can go. Entries of earlier rounds, and of frames that are past,
+ * are free.
+ *
+ * @return The slot, or NULL if the neighborhood is full.
+ */
+static autopilot_entry *memo_slot(autopilot *ap, int frame, flappy f) {
+	uint32_t h = (uint32_t) frame * 0x9E3779B1u ^ (uint32_t) f.y * 0x85EBCA77u
+			^ (uint32_t) f.v * 0xC2B2AE3Du;
+	autopilot_entry *e;
+	int i;
+
+	h ^= h >> 15;
+	for (i = 0; i < MAX_PROBES; i++) {
+		e = &ap->memo[(h + i) & (AUTOPILOT_MEMO - 1)];
+		if (e->round != ap->round || e->frame < ap->s->frame ||
+				(e->frame == frame && e->f.y == f.y && e->f.v == f.v))
+			return e;
+	}
+	return NULL;
+}
+
+/**
+ * Returns true if Flappy, moving from height y0 to f during the frame that
+ * ends on frame number 'frame', hits the ceiling, the floor or a pipe. The
+ * same checks as sim_step(), with the pipes shifted to where they will be.
+ */
+static int crashes(const autopilot *ap, int frame, int y0, flappy f) {
+	const pipe_pool *pool = &ap->s->pipes;
+	int h = get_flappy_position(f), n = pool->scroll, j;
+	int ahead = frame - ap->s->frame;
+
+	if (h <= 0 || h >= ap->s->rows - 1)
+		return 1;
+	for (j = 1; j <= n; j++) {
+		flappy at = f;
+		at.y = y0 + (int64_t) (f.y - y0) * j / n;
+		if (crashed_into_pipes(get_flappy_position(at), pool,
+				-((ahead - 1) * n + j)))
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Searches the moves from a state, gliding first.
+ *
+ * @param ap
+ * @param frame Frame number of the state.
+ * @param f Flappy at that point.
+ * @param limit Frame number to look ahead to.
+ *
+ * @return Frame number Flappy gets to without crashing, at most 'limit'.
+ */
+static int search(autopilot *ap, int frame, flappy f, int limit) {
+	autopilot_entry *e;
+	int input, reach = frame, move = -1, r;
+
+	if (frame >= limit)
+		return frame;
+
+	// Known already, either as a dead end or as far as we need to look?
+	// Otherwise, if it's known how to get as far as the last search looked,
+	// try that way first.
+	e = memo_slot(ap, frame, f);
+	if (e && e->round == ap->round && e->frame == frame) {
+		if (e->reach < e->limit)
+			return e->reach < limit ? e->reach : limit;
+		if (e->limit >= limit)
+			return limit;
+		if (e->move >= 0) {
+			flappy next = f;
+			flappy_move(&next, e->move);
+			if (search(ap, frame + 1, next, limit) >= limit) {
+				e->limit = e->reach = limit;
+				return limit;
+			}
+		}
+	}
+
+	for (input = INPUT_NONE; input <= INPUT_FLAP && reach < limit; input++) {
+		flappy next = f;
+		flappy_move(&next, input);
+		if (crashes(ap, frame + 1, f.y, next))
+			continue;
+		r = search(ap, frame + 1, next, limit);
+		if (r > reach) {
+			reach = r;
+			move = input;
+		}
+	}
+
+	// The slot may have been taken by the searches above.
+	if ((e = memo_slot(ap, frame, f))) {
+		e->round = ap->round;
+		e->frame = frame;
+		e->f = f;
+		e->reach = reach;
+		e->limit = limit;
+		e->move = move;
+	}
+	return reach;
+}
+
+/**
+ * Gets the frame number Flappy gets to if he starts with the given move.
+ */
+static int try_move(autopilot *ap, int input, int limit) {
+	const game_state *s = ap->s;
+	flappy next = s->bird;
+
+	flappy_move(&next, input);
+	return crashes(ap, s->frame + 1, s->bird.y, next) ? s->frame :
+			search(ap, s->frame + 1, next, limit);
+}
+
+/**
+ * Starts a new round of memoized states if the game isn't the one the last
+ * decision was about anymore.
+ */
+static void follow_game(autopilot *ap, const game_state *s) {
+	int i;
+
+	if (s->frame >= ap->frame && s->seed == ap->seed && s->rows == ap->rows &&
+			s->cols == ap->cols && s->pipes.scroll == ap->scroll)
+		return;
+
+	if (++ap->round == 0) { // Wrapped around: old entries could look current.
+		for (i = 0; i < AUTOPILOT_MEMO; i++)
+			ap->memo[i].round = 0;
+		ap->round = 1;
+	}
+	ap->seed = s->seed;
+	ap->rows = s->rows;
+	ap->cols = s->cols;
+	ap->scroll = s->pipes.scroll;
+}
+
+/**
+ * Decides what to do this frame: glide, unless flapping keeps Flappy alive
+ * for longer.
+ *
+ * @param ap
+ * @param s Game to play; it is only looked at.
+ *
+ * @return INPUT_FLAP or INPUT_NONE, for sim_step().
+ */
+int autopilot_decide(autopilot *ap, const game_state *s) {
+	const pipe_pool *pool = &s->pipes;
+	int ahead = ap->horizon, unseen, limit, glide;
+
+	// Don't look so far ahead that a pipe that isn't spawned yet could get
+	// to Flappy.
+	if (pool->count > 0) {
+		unseen = (POOL_PIPE(pool, pool->count - 1).center + pool->spacing -
+				PIPE_RADIUS - 2 - FLAPPY_COL) / pool->scroll;
+		if (unseen < ahead)
+			ahead = unseen > 1 ? unseen : 1;
+	}
+
+	follow_game(ap, s);
+	ap->frame = s->frame;
+	ap->s = s;
+	limit = s->frame + ahead;
+
+	glide = try_move(ap, INPUT_NONE, limit);
+	if (glide >= limit)
+		return INPUT_NONE;
+	return try_move(ap, INPUT_FLAP, limit) > glide ? INPUT_FLAP : INPUT_NONE;
+}
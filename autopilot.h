@@ -0,0 +1,78 @@
+/**
+ * @file
+ *
+ * Search-based autopilot, for --autoplay. Every frame it looks ahead with
+ * the headless physics over a bounded number of frames, trying both
+ * choices at every frame, and flaps only if gliding leads into a crash
+ * sooner. Pipes scroll by a fixed amount per frame, so the board a number
+ * of frames ahead is known exactly; only pipes that haven't been spawned
+ * yet are unknown, and the horizon is kept short enough that those can't
+ * reach Flappy.
+ *
+ * Different move orders often reach the same Flappy at the same frame, and
+ * each decision looks at mostly the same states as the one before, only
+ * one frame further. So the outcome of every state searched is memoized,
+ * keyed on Flappy's height and velocity (his row and the time since his
+ * last flap) and the frame number (how far the pipes have moved), for as
+ * long as the round lasts. Most decisions only look at a few new states.
+ */
+
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stdint.h>
+
+#include "sim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Number of entries in an autopilot's memo. Must be a power of two. */
+#define AUTOPILOT_MEMO 16384
+
+/** A searched state and how far Flappy gets from it. */
+typedef struct autopilot_entry {
+	/* Round the entry belongs to; entries of earlier rounds are free. */
+	uint32_t round;
+
+	/* Frame number of the state, and Flappy then. */
+	int frame;
+	flappy f;
+
+	/*
+	 * Frame Flappy survives to from here, and how far the search looked. If
+	 * 'reach' is short of 'limit' Flappy crashes there whatever he does.
+	 */
+	int reach, limit;
+
+	/* Move that gets Flappy to 'reach', or -1 if he crashes either way. */
+	int move;
+} autopilot_entry;
+
+/** Lookahead state of the autopilot. */
+typedef struct autopilot {
+	/* Most frames looked ahead. */
+	int horizon;
+
+	/*
+	 * Number of the round being played, and what it was told apart from
+	 * the next one by: a new round starts whenever the game restarts or
+	 * changes shape, which makes every memoized state stale.
+	 */
+	uint32_t round;
+	unsigned int seed;
+	int frame, rows, cols, scroll;
+
+	/* Searched states, as an open-addressed hash table. */
+	autopilot_entry *memo;
+
+	/* The game being looked ahead in. */
+	const game_state *s;
+} autopilot;
+
+//---------------------------------- Functions --------------------------------
+
+int autopilot_init(autopilot *ap, int horizon);
+void autopilot_free(autopilot *ap);
+int autopilot_decide(autopilot *ap, const game_state *s);
+
+#endif
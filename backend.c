@@ -0,0 +1,256 @@
+/**
+ * @file
+ *
+ * The ncurses and raw ANSI terminal backends. See backend.h.
+ */
+
+#include <errno.h>
+#include <ncurses.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ansi.h"
+#include "backend.h"
+#include "render.h"
+#include "session.h"
+
+//------------------------------ Global Constants -----------------------------
+
+/**
+ * Most keys term_drain() takes in one go, so a flood of input (e.g. a paste)
+ * can't hold up a frame for long; the rest waits for the next tick.
+ */
+static const int MAX_DRAIN = 256;
+
+/** Switch to the alternate screen and hide the cursor, and back. */
+static const char ANSI_ENTER[] = "\033[?1049h\033[?25l";
+static const char ANSI_LEAVE[] = "\033[?25h\033[?1049l";
+
+//------------------------------ Global Variables -----------------------------
+
+/** What ncurses shows, for term_curses. */
+static renderer curses_r;
+
+/** What the terminal shows and the frame output buffer, for term_ansi. */
+static ansi_renderer ansi_r;
+static outbuf ansi_out;
+
+/** Terminal settings to restore when term_ansi is done. */
+static struct termios ansi_saved;
+
+/** Bytes read from the terminal but not yet decoded into keys. */
+static unsigned char ansi_in[64];
+static int ansi_in_pos, ansi_in_len;
+static key_decoder ansi_keys;
+
+/** Set by the SIGWINCH handler when the terminal changes size. */
+static volatile sig_atomic_t ansi_resized;
+
+//---------------------------------- Functions --------------------------------
+
+static int curses_open(void) {
+	initscr();
+	raw();					// Disable line buffering
+	keypad(stdscr, TRUE);
+	noecho();				// Don't echo() for getch
+	curs_set(0);
+	timeout(0);				// Don't block on input.
+	return 0;
+}
+
+static void curses_close(void) {
+	endwin();
+	render_free(&curses_r);
+}
+
+static void curses_size(int *rows, int *cols) {
+	getmaxyx(stdscr, *rows, *cols);
+}
+
+static int curses_resize(int rows, int cols) {
+	return render_resize(&curses_r, rows, cols);
+}
+
+static int curses_read_key(void) {
+	int ch = getch();
+
+	switch (ch) {
+	case ERR:
+		return TERM_NO_KEY;
+	case KEY_UP:
+		return TERM_KEY_UP;
+	case KEY_RESIZE:
+		return TERM_KEY_RESIZE;
+	default:
+		return ch < 256 ? ch : TERM_KEY_OTHER;
+	}
+}
+
+static void curses_flush(const cellbuf *frame) {
+	render_flush(&curses_r, frame);
+}
+
+/**
+ * Writes all of a buffer to the terminal, riding out signals.
+ */
+static void ansi_write(const char *data, size_t len) {
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(STDOUT_FILENO, data, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		data += n;
+		len -= n;
+	}
+}
+
+static void ansi_on_winch(int sig) {
+	(void) sig;
+	ansi_resized = 1;
+}
+
+/**
+ * Puts the terminal in raw, non-blocking mode on the alternate screen.
+ *
+ * @return 0 on success, -1 with errno set if stdin and stdout aren't a
+ * terminal.
+ */
+static int ansi_open(void) {
+	struct termios raw;
+	struct sigaction sa;
+
+	if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+		errno = ENOTTY;
+		return -1;
+	}
+	if (tcgetattr(STDIN_FILENO, &ansi_saved))
+		return -1;
+	raw = ansi_saved;
+	cfmakeraw(&raw);
+	raw.c_cc[VMIN] = 0;  // Don't block on input.
+	raw.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &raw))
+		return -1;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = ansi_on_winch;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGWINCH, &sa, NULL);
+
+	ansi_write(ANSI_ENTER, sizeof(ANSI_ENTER) - 1);
+	return 0;
+}
+
+static void ansi_close(void) {
+	signal(SIGWINCH, SIG_DFL);
+	ansi_write(ANSI_LEAVE, sizeof(ANSI_LEAVE) - 1);
+	tcsetattr(STDIN_FILENO, TCSANOW, &ansi_saved);
+	ansi_free(&ansi_r);
+	outbuf_free(&ansi_out);
+}
+
+static void ansi_size(int *rows, int *cols) {
+	struct winsize ws;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 &&
+			ws.ws_col > 0) {
+		*rows = ws.ws_row;
+		*cols = ws.ws_col;
+	}
+	else {
+		*rows = 24;
+		*cols = 80;
+	}
+}
+
+/**
+ * Sets the emitter up for the new size and allocates the output buffer to
+ * fit a full repaint, with a cursor move per row, so frames don't allocate.
+ */
+static int ansi_resize_term(int rows, int cols) {
+	if (ansi_resize(&ansi_r, rows, cols))
+		return -1;
+	ansi_out.len = 0;
+	return outbuf_reserve(&ansi_out, (size_t) rows * (cols + 16) + 64);
+}
+
+/**
+ * Decodes the next key (see key_decode()), reading more from the terminal
+ * once the bytes read so far run out.
+ */
+static int ansi_read_key(void) {
+	ssize_t n;
+	int key;
+
+	if (ansi_resized) {
+		ansi_resized = 0;
+		return TERM_KEY_RESIZE;
+	}
+
+	for (;;) {
+		if (ansi_in_pos == ansi_in_len) {
+			if ((key = key_decode_end(&ansi_keys)) != TERM_NO_KEY)
+				return key;
+			n = read(STDIN_FILENO, ansi_in, sizeof(ansi_in));
+			if (n <= 0)
+				return TERM_NO_KEY;
+			ansi_in_pos = 0;
+			ansi_in_len = n;
+		}
+		if ((key = key_decode(&ansi_keys, ansi_in[ansi_in_pos++])) !=
+				TERM_NO_KEY)
+			return key;
+	}
+}
+
+/**
+ * Sends the frame's changes with one write(), bracketed so terminals that
+ * support synchronized updates draw it in one go.
+ */
+static void ansi_flush_term(const cellbuf *frame) {
+	size_t begin = strlen(ANSI_SYNC_BEGIN);
+
+	ansi_out.len = 0;
+	ansi_out.failed = 0;
+	outbuf_put(&ansi_out, ANSI_SYNC_BEGIN, begin);
+	ansi_flush(&ansi_r, frame, &ansi_out);
+	if (ansi_out.len == begin)
+		return; // Nothing changed.
+	outbuf_puts(&ansi_out, ANSI_SYNC_END);
+
+	if (ansi_out.failed)
+		ansi_invalidate(&ansi_r); // Lost some output; repaint next time.
+	else
+		ansi_write(ansi_out.data, ansi_out.len);
+}
+
+/**
+ * Reads every key that is waiting, without blocking, and adds them to what
+ * was pressed so far.
+ *
+ * @param b Backend to read from.
+ * @param in What was pressed.
+ */
+void term_drain(const term_backend *b, term_input *in) {
+	int key, n;
+
+	for (n = 0; n < MAX_DRAIN && (key = b->read_key()) != TERM_NO_KEY; n++)
+		input_add(in, key);
+}
+
+const term_backend term_curses = {
+	curses_open, curses_close, curses_size, curses_resize, curses_read_key,
+	curses_flush, STDIN_FILENO
+};
+
+const term_backend term_ansi = {
+	ansi_open, ansi_close, ansi_size, ansi_resize_term, ansi_read_key,
+	ansi_flush_term, STDIN_FILENO
+};
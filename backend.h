@@ -0,0 +1,91 @@
+/**
+ * @file
+ *
+ * Terminal backends for the interactive game. Frames are composed in a
+ * cellbuf no matter what; a backend owns the terminal and gets the frames
+ * onto it, reads the keyboard and reports size changes. Two are built in:
+ *
+ * - term_curses, the default, drives the terminal through ncurses and the
+ *   diffing renderer in render.h.
+ * - term_ansi puts the terminal in raw mode itself and writes the diffing
+ *   ANSI emitter's output (ansi.h) with a single write() per frame, out of
+ *   a buffer that is allocated once per terminal size. It skips ncurses
+ *   altogether and assumes a VT100-compatible terminal.
+ */
+
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <time.h>
+
+#include "cellbuf.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Keys the backends report besides plain characters. */
+enum term_key {
+	TERM_NO_KEY = -1,      // Nothing was pressed.
+	TERM_KEY_UP = 256,
+	TERM_KEY_RESIZE,       // The terminal changed size.
+	TERM_KEY_OTHER         // Some other special key.
+};
+
+/** A way of driving the terminal. */
+typedef struct term_backend {
+	/*
+	 * Takes over the terminal: no line buffering, no echo, no cursor.
+	 * Returns 0 on success, -1 on error.
+	 */
+	int (*open)(void);
+
+	/* Gives the terminal back the way it was. */
+	void (*close)(void);
+
+	/* Gets the terminal's size. */
+	void (*size)(int *rows, int *cols);
+
+	/* Sets up for frames of a new size. Returns 0, or -1 if out of memory. */
+	int (*resize)(int rows, int cols);
+
+	/* Gets the next key without waiting, or TERM_NO_KEY if there's none. */
+	int (*read_key)(void);
+
+	/* Brings the terminal up to date with a frame of the current size. */
+	void (*flush)(const cellbuf *frame);
+
+	/* File descriptor that becomes readable when there are keys to read. */
+	int fd;
+} term_backend;
+
+/**
+ * The keys pressed since the last tick, boiled down to what the game uses.
+ * Clear it to all zeros before the first term_drain().
+ */
+typedef struct term_input {
+	/* Number of times the up arrow was pressed. */
+	int flaps;
+
+	/* Nonzero if 'q' was pressed. */
+	int quit;
+
+	/* Nonzero if the terminal changed size. */
+	int resized;
+
+	/* Nonzero if any other key was pressed. */
+	int other;
+
+	/* Number of keys read, and when the first of them was. */
+	int keys;
+	struct timespec first;
+} term_input;
+
+//------------------------------ Global Constants -----------------------------
+
+extern const term_backend term_curses;
+extern const term_backend term_ansi;
+
+//---------------------------------- Functions --------------------------------
+
+void term_drain(const term_backend *b, term_input *in);
+
+#endif
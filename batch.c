@@ -0,0 +1,314 @@
+/**
+ * @file
+ *
+ * Multi-threaded batch evaluator. See batch.h.
+ *
+ * Episode lengths vary a lot, so a static split of the episodes over the
+ * threads leaves most threads idle at the end. Instead every worker owns a
+ * range of job numbers that it works through from the front, and a worker
+ * that runs out steals the back half of another worker's range. A range is
+ * packed into one 64-bit atomic so both taking a job and stealing are a
+ * single compare-and-swap.
+ *
+ * Batches of the default policy on the classic game, which most are, are
+ * played on the lockstep engine in vecsim.c instead of one episode at a
+ * time, a block of episodes per job. Every episode still ends exactly as
+ * batch_episode() would play it.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "batch.h"
+#include "vecsim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Jobs to be run by a batch_for() call, shared by all of its workers. */
+typedef struct job_set {
+	int threads;
+	void (*job)(void *arg, int i);
+	void *arg;
+} job_set;
+
+/** A worker thread and the jobs it still has to run. */
+typedef struct worker {
+	/*
+	 * Jobs [lo, hi) not yet started, packed as lo << 32 | hi. Aligned so
+	 * that neighboring workers' ranges don't share a cache line.
+	 */
+	_Alignas(64) _Atomic uint64_t range;
+
+	/* Index of this worker, and all of the workers. */
+	int id;
+	struct worker *all;
+
+	const job_set *jobs;
+	pthread_t thread;
+} worker;
+
+/** A batch of episodes in progress, for batch_run(). */
+typedef struct episode_set {
+	const batch_config *cfg;
+	episode_result *results;
+
+	/* Episodes per job. */
+	int block;
+} episode_set;
+
+//------------------------------ Global Constants -----------------------------
+
+/** Most episodes a job plays in lockstep. */
+static const int LOCKSTEP_GAMES = 256;
+
+//---------------------------------- Functions --------------------------------
+
+static uint64_t pack_range(uint32_t lo, uint32_t hi) {
+	return (uint64_t) lo << 32 | hi;
+}
+
+/**
+ * Default policy: flap when Flappy has sunk below the middle of the next
+ * pipe's opening and hasn't just flapped.
+ */
+int batch_policy(const game_state *s) {
+	const vpipe *p = sim_next_pipe(s);
+
+	return s->bird.v > V0 + 3 * GRAV &&
+			get_flappy_position(s->bird) > (p->top_orow + p->bottom_orow) / 2 ?
+			INPUT_FLAP : INPUT_NONE;
+}
+
+/**
+ * Plays episode 'i' of a batch from start to finish.
+ */
+void batch_episode(const batch_config *cfg, int i, episode_result *result) {
+	game_state s;
+	int frames = 0;
+
+	sim_init(&s, cfg->rows, cfg->cols, cfg->seed + i);
+	sim_set_scroll(&s, cfg->scroll);
+	if (cfg->profile)
+		sim_set_profile(&s, cfg->profile);
+	while (!s.dead && (!cfg->max_frames || frames < cfg->max_frames)) {
+		sim_step(&s, cfg->policy(&s));
+		frames++;
+	}
+	result->score = s.score;
+	result->frames = frames;
+}
+
+/**
+ * Takes the next job from the front of the worker's own range.
+ *
+ * @return Job number, or -1 if the range is empty.
+ */
+static int take_own(worker *w) {
+	uint64_t r = atomic_load(&w->range);
+	uint32_t lo, hi;
+
+	do {
+		lo = r >> 32;
+		hi = (uint32_t) r;
+		if (lo >= hi)
+			return -1;
+	} while (!atomic_compare_exchange_weak(&w->range, &r,
+			pack_range(lo + 1, hi)));
+	return lo;
+}
+
+/**
+ * Moves the back half of some other worker's range into this worker's
+ * (empty) range.
+ *
+ * @return 1 if anything was stolen, 0 if every other worker is out of work.
+ */
+static int steal(worker *w) {
+	int n = w->jobs->threads, k;
+
+	for (k = 1; k < n; k++) {
+		worker *victim = &w->all[(w->id + k) % n];
+		uint64_t r = atomic_load(&victim->range);
+		uint32_t lo, hi, take;
+
+		do {
+			lo = r >> 32;
+			hi = (uint32_t) r;
+			if (lo >= hi)
+				break;
+			take = (hi - lo + 1) / 2;
+		} while (!atomic_compare_exchange_weak(&victim->range, &r,
+				pack_range(lo, hi - take)));
+
+		if (lo < hi) {
+			atomic_store(&w->range, pack_range(hi - take, hi));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void *work(void *arg) {
+	worker *w = arg;
+	int i;
+
+	do {
+		while ((i = take_own(w)) >= 0)
+			w->jobs->job(w->jobs->arg, i);
+	} while (steal(w));
+
+	return NULL;
+}
+
+/**
+ * Runs job(arg, i) for every i in [0, count) on a pool of worker threads
+ * that steal work from each other, and waits for all of them to finish.
+ * Jobs may run in any order and on any thread.
+ *
+ * @param count Number of jobs.
+ * @param threads Number of worker threads.
+ * @param job Runs one job.
+ * @param arg Passed to every job.
+ *
+ * @return 0 on success, -1 if the worker threads couldn't be started.
+ */
+int batch_for(int count, int threads, void (*job)(void *arg, int i),
+		void *arg) {
+	job_set jobs = { threads, job, arg };
+	worker *workers;
+	int t, n = threads, started;
+
+	workers = aligned_alloc(_Alignof(worker), n * sizeof(worker));
+	if (!workers)
+		return -1;
+
+	// Start each worker on an equal share of the jobs.
+	for (t = 0; t < n; t++) {
+		workers[t].id = t;
+		workers[t].all = workers;
+		workers[t].jobs = &jobs;
+		atomic_init(&workers[t].range,
+				pack_range((uint64_t) count * t / n,
+						(uint64_t) count * (t + 1) / n));
+	}
+
+	for (started = 0; started < n; started++)
+		if (pthread_create(&workers[started].thread, NULL, work,
+				&workers[started]))
+			break;
+
+	// If some threads didn't start, the others steal their share.
+	for (t = 0; t < started; t++)
+		pthread_join(workers[t].thread, NULL);
+
+	free(workers);
+	return started ? 0 : -1;
+}
+
+static void episode_job(void *arg, int i) {
+	episode_set *set = arg;
+	batch_episode(set->cfg, i, &set->results[i]);
+}
+
+/**
+ * Plays the episodes of block 'b' of a batch in lockstep on a vec_world.
+ * Falls back on playing them one at a time if out of memory.
+ */
+static void lockstep_job(void *arg, int b) {
+	episode_set *set = arg;
+	const batch_config *cfg = set->cfg;
+	episode_result *results = set->results + b * set->block;
+	int first = b * set->block, n = cfg->episodes - first;
+	int i, frames = 0, alive, was_alive;
+	unsigned char *flap;
+	game_state s;
+	vec_world w;
+
+	if (n > set->block)
+		n = set->block;
+	sim_init(&s, cfg->rows, cfg->cols, cfg->seed + first);
+	flap = malloc(n);
+	if (!flap || vec_world_init(&w, n, &s)) {
+		free(flap);
+		for (i = 0; i < n; i++)
+			batch_episode(cfg, first + i, &results[i]);
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		if (i > 0)
+			sim_init(&s, cfg->rows, cfg->cols, cfg->seed + first + i);
+		vec_world_load(&w, i, &s);
+		results[i].frames = 0;
+	}
+
+	// An episode's frames count the one it died in, which is never the
+	// 0th, so 0 marks the episodes that are still going.
+	alive = n;
+	while (alive > 0 && (!cfg->max_frames || frames < cfg->max_frames)) {
+		vec_world_policy(&w, flap);
+		was_alive = alive;
+		alive = vec_world_step(&w, flap);
+		frames++;
+		if (alive < was_alive)
+			for (i = 0; i < n; i++)
+				if (w.dead[i] && results[i].frames == 0)
+					results[i].frames = frames;
+	}
+	for (i = 0; i < n; i++) {
+		results[i].score = w.score[i];
+		if (results[i].frames == 0)
+			results[i].frames = frames;
+	}
+
+	vec_world_free(&w);
+	free(flap);
+}
+
+/**
+ * Plays all episodes of a batch.
+ *
+ * @param cfg What to play.
+ * @param[out] results One entry per episode, filled in by episode number.
+ *
+ * @return 0 on success, -1 if the worker threads couldn't be started.
+ */
+int batch_run(const batch_config *cfg, episode_result *results) {
+	episode_set set = { cfg, results, 1 };
+
+	if (cfg->policy != batch_policy || cfg->scroll != 1 || cfg->profile)
+		return batch_for(cfg->episodes, cfg->threads, episode_job, &set);
+
+	// Give every thread a block at least, so none sits idle.
+	set.block = (cfg->episodes + cfg->threads - 1) / cfg->threads;
+	if (set.block > LOCKSTEP_GAMES)
+		set.block = LOCKSTEP_GAMES;
+	if (set.block < 1)
+		set.block = 1;
+	return batch_for((cfg->episodes + set.block - 1) / set.block,
+			cfg->threads, lockstep_job, &set);
+}
+
+/**
+ * Prints a summary of a finished batch.
+ */
+void batch_report(FILE *out, const batch_config *cfg,
+		const episode_result *results, double seconds) {
+	long long frames = 0, total = 0;
+	int i, best = 0;
+
+	for (i = 0; i < cfg->episodes; i++) {
+		frames += results[i].frames;
+		total += results[i].score;
+		if (results[i].score > best)
+			best = results[i].score;
+	}
+
+	fprintf(out, "episodes: %d  threads: %d  seed: %u\n",
+			cfg->episodes, cfg->threads, cfg->seed);
+	fprintf(out, "score: mean %.2f  best %d\n",
+			cfg->episodes ? (double) total / cfg->episodes : 0.0, best);
+	fprintf(out, "frames: %lld in %.3f s (%.0f frames/s)\n",
+			frames, seconds, seconds > 0 ? frames / seconds : 0.0);
+}
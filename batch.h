@@ -0,0 +1,59 @@
+/**
+ * @file
+ *
+ * Headless batch evaluation: plays many complete episodes spread over worker
+ * threads. Episode i is seeded with seed + i, so the outcome of every
+ * episode is the same no matter how many threads there are or which thread
+ * runs it.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+
+#include "profile.h"
+#include "sim.h"
+
+/** Settings for a batch of episodes. */
+typedef struct batch_config {
+	/* Number of episodes to play. */
+	int episodes;
+
+	/* Number of worker threads. */
+	int threads;
+
+	/* Cut episodes off after this many frames; 0 for no limit. */
+	int max_frames;
+
+	/* Seed of the first episode. */
+	unsigned int seed;
+
+	/* Board size for every episode. */
+	int rows, cols;
+
+	/* Columns the pipes move every frame; see sim_set_scroll(). */
+	int scroll;
+
+	/* Difficulty profile of every episode, or NULL; it overrides 'scroll'. */
+	const profile *profile;
+
+	/* Decides INPUT_FLAP or INPUT_NONE for each frame. */
+	int (*policy)(const game_state *s);
+} batch_config;
+
+/** Outcome of one episode. */
+typedef struct episode_result {
+	int score;
+	int frames;
+} episode_result;
+
+int batch_policy(const game_state *s);
+void batch_episode(const batch_config *cfg, int i, episode_result *result);
+int batch_for(int count, int threads, void (*job)(void *arg, int i),
+		void *arg);
+int batch_run(const batch_config *cfg, episode_result *results);
+void batch_report(FILE *out, const batch_config *cfg,
+		const episode_result *results, double seconds);
+
+#endif
@@ -0,0 +1,332 @@
+/**
+ * @file
+ *
+ * Microbenchmarks for the physics, collision and drawing code, for catching
+ * performance regressions: run with "make bench". Every benchmark runs one
+ * operation in a tight loop, with enough iterations to take a noticeable
+ * fraction of a second, and reports the time per operation. Drawing is done
+ * into an off-screen cellbuf; the terminal output benchmarks send their
+ * frames to a ncurses screen on /dev/null and into an ANSI output buffer.
+ *
+ * Usage: flap-bench [NAME]... runs only the benchmarks whose names contain
+ * one of the given words.
+ */
+
+#include <ncurses.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ansi.h"
+#include "autopilot.h"
+#include "cellbuf.h"
+#include "draw.h"
+#include "render.h"
+#include "sim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** A benchmark: runs its operation 'iters' times. */
+typedef struct benchmark {
+	const char *name;
+
+	/*
+	 * Returns something computed from the results, so nothing is optimized
+	 * away.
+	 */
+	long (*run)(long iters);
+
+	/* Nonzero if an operation is a whole frame, to report frames/s. */
+	int per_frame;
+} benchmark;
+
+//------------------------------ Global Constants -----------------------------
+
+/** Each benchmark runs for at least this long once calibrated. */
+static const double MIN_SECONDS = 0.25;
+
+/** Inputs are cycled through tables of this many entries. */
+#define NUM_INPUTS 64
+
+//------------------------------ Global Variables -----------------------------
+
+/** A game in mid-flight that the benchmarks draw their inputs from. */
+static game_state game;
+
+/** Layout and frame buffer the drawing benchmarks draw into. */
+static layout lay;
+static cellbuf frame;
+
+/** Consecutive frames of a game, for the terminal output benchmarks. */
+static cellbuf frames[NUM_INPUTS];
+
+/** Results are folded into this so the benchmarks can't be optimized out. */
+static volatile long sink;
+
+//---------------------------------- Functions --------------------------------
+
+static double now_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Gets the i-th of a spread of pipes across the board.
+ */
+static vpipe input_pipe(int i) {
+	vpipe p;
+	uint64_t rng;
+
+	sim_seed_rng(&rng, i);
+	p.center = i * (NUM_COLS + 2 * PIPE_RADIUS) / NUM_INPUTS - PIPE_RADIUS;
+	p.opening_height = random_opening_height(&rng);
+	p.opening_width = OPENING_WIDTH;
+	pipe_shape(&p, NUM_ROWS);
+	return p;
+}
+
+static long bench_position(long iters) {
+	flappy f = { 0, V0 };
+	long i, sum = 0;
+
+	for (i = 0; i < iters; i++) {
+		f.y = (i % (NUM_ROWS * ROW_SCALE));
+		sum += get_flappy_position(f);
+	}
+	return sum;
+}
+
+static long bench_crash(long iters) {
+	vpipe pipes[NUM_INPUTS];
+	long i, sum = 0;
+
+	for (i = 0; i < NUM_INPUTS; i++)
+		pipes[i] = input_pipe(i);
+	for (i = 0; i < iters; i++)
+		sum += crashed_into_pipe(i % NUM_ROWS, pipes[i % NUM_INPUTS]);
+	return sum;
+}
+
+static long bench_orow(long iters) {
+	vpipe pipes[NUM_INPUTS];
+	long i, sum = 0;
+
+	for (i = 0; i < NUM_INPUTS; i++)
+		pipes[i] = input_pipe(i);
+	for (i = 0; i < iters; i++)
+		sum += get_orow(pipes[i % NUM_INPUTS], i & 1, NUM_ROWS);
+	return sum;
+}
+
+static long bench_pipe_refresh(long iters) {
+	game_state s = game;
+	long i;
+
+	for (i = 0; i < iters; i++)
+		pipe_refresh(&s);
+	return s.score;
+}
+
+static long bench_step(long iters) {
+	game_state s = game;
+	long i, sum = 0;
+
+	for (i = 0; i < iters; i++) {
+		// Flap whenever Flappy sinks below the middle of the board.
+		sim_step(&s, get_flappy_position(s.bird) > s.rows / 2 ?
+				INPUT_FLAP : INPUT_NONE);
+		if (s.dead) {
+			sum += s.score;
+			sim_restart(&s);
+		}
+	}
+	return sum + s.frame;
+}
+
+static long bench_autopilot(long iters) {
+	game_state s = game;
+	autopilot ap;
+	long i, sum = 0;
+
+	if (autopilot_init(&ap, 40))
+		return 0;
+	for (i = 0; i < iters; i++) {
+		sim_step(&s, autopilot_decide(&ap, &s));
+		if (s.dead) {
+			sum += s.score;
+			sim_restart(&s);
+		}
+	}
+	autopilot_free(&ap);
+	return sum + s.frame;
+}
+
+static long bench_draw_pipe(long iters) {
+	vpipe pipes[NUM_INPUTS];
+	long i;
+
+	for (i = 0; i < NUM_INPUTS; i++)
+		pipes[i] = input_pipe(i);
+	for (i = 0; i < iters; i++)
+		draw_pipe(&frame, &lay, pipes[i % NUM_INPUTS], '|', '=', '=');
+	return CELL(&frame, NUM_ROWS / 2, NUM_COLS / 2);
+}
+
+static long bench_draw_floor(long iters) {
+	long i;
+
+	for (i = 0; i < iters; i++)
+		draw_floor_and_ceiling(&frame, &lay, &game, '/', 2, i & 1);
+	return CELL(&frame, 0, 1);
+}
+
+static long bench_draw_game(long iters) {
+	game_state s = game;
+	long i;
+
+	for (i = 0; i < iters; i++) {
+		pipe_refresh(&s); // Keep the pipes moving.
+		draw_game(&frame, &lay, &s);
+	}
+	return CELL(&frame, NUM_ROWS / 2, NUM_COLS / 2);
+}
+
+static long bench_render(long iters) {
+	renderer r;
+	long i;
+
+	if (render_init(&r, NUM_ROWS, NUM_COLS))
+		return 0;
+	for (i = 0; i < iters; i++)
+		render_flush(&r, &frames[i % NUM_INPUTS]);
+	render_free(&r);
+	return i;
+}
+
+static long bench_ansi(long iters) {
+	ansi_renderer r;
+	outbuf out = { NULL, 0, 0, 0 };
+	long i, bytes = 0;
+
+	if (ansi_init(&r, NUM_ROWS, NUM_COLS))
+		return 0;
+	for (i = 0; i < iters; i++) {
+		out.len = 0;
+		ansi_flush(&r, &frames[i % NUM_INPUTS], &out);
+		bytes += out.len;
+	}
+	ansi_free(&r);
+	outbuf_free(&out);
+	return bytes;
+}
+
+/** All the benchmarks, cheapest first. */
+static const benchmark benchmarks[] = {
+	{ "get_flappy_position",    bench_position,     0 },
+	{ "crashed_into_pipe",      bench_crash,        0 },
+	{ "get_orow",               bench_orow,         0 },
+	{ "pipe_refresh",           bench_pipe_refresh, 0 },
+	{ "sim_step",               bench_step,         0 },
+	{ "autopilot_decide",       bench_autopilot,    0 },
+	{ "draw_pipe",              bench_draw_pipe,    0 },
+	{ "draw_floor_and_ceiling", bench_draw_floor,   0 },
+	{ "draw_game",              bench_draw_game,    1 },
+	{ "render_flush",           bench_render,       1 },
+	{ "ansi_flush",             bench_ansi,         1 },
+};
+
+/**
+ * Runs a benchmark with more and more iterations until it takes at least
+ * MIN_SECONDS, then prints its time per operation.
+ */
+static void run(const benchmark *b) {
+	long iters = 1000;
+	double start, seconds, ns;
+
+	for (;;) {
+		start = now_seconds();
+		sink += b->run(iters);
+		seconds = now_seconds() - start;
+		if (seconds >= MIN_SECONDS)
+			break;
+		iters *= seconds < MIN_SECONDS / 16 ? 16 : 2;
+	}
+
+	ns = seconds * 1e9 / iters;
+	printf("%-24s %10.1f ns/op", b->name, ns);
+	if (b->per_frame)
+		printf(" %12.0f frames/s", 1e9 / ns);
+	printf("\n");
+}
+
+/**
+ * Returns true if the benchmark was asked for on the command line.
+ */
+static int selected(const benchmark *b, int argc, char **argv) {
+	int i;
+
+	if (argc < 2)
+		return 1;
+	for (i = 1; i < argc; i++)
+		if (strstr(b->name, argv[i]))
+			return 1;
+	return 0;
+}
+
+/**
+ * Sets up the game, frame buffers and null terminal the benchmarks use.
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int setup(void) {
+	FILE *null_out, *null_in;
+	const char *term = getenv("TERM");
+	game_state s;
+	int i;
+
+	sim_init(&game, NUM_ROWS, NUM_COLS, 1);
+	for (i = 0; i < 3 * NUM_COLS; i++)
+		pipe_refresh(&game); // Bring pipes onto the screen.
+	layout_compute(&lay, NUM_ROWS, NUM_COLS);
+	if (cellbuf_init(&frame, NUM_ROWS, NUM_COLS))
+		return -1;
+
+	s = game;
+	for (i = 0; i < NUM_INPUTS; i++) {
+		if (cellbuf_init(&frames[i], NUM_ROWS, NUM_COLS))
+			return -1;
+		sim_step(&s, i % 8 == 0 ? INPUT_FLAP : INPUT_NONE);
+		draw_game(&frames[i], &lay, &s);
+	}
+
+	// A real ncurses screen that writes to nowhere, for render_flush().
+	null_out = fopen("/dev/null", "w");
+	null_in = fopen("/dev/null", "r");
+	if (!term || !*term)
+		term = "vt100";
+	if (!null_out || !null_in || !newterm(term, null_out, null_in))
+		return -1;
+	resizeterm(NUM_ROWS, NUM_COLS);
+	return 0;
+}
+
+//------------------------------------ Main -----------------------------------
+
+int main(int argc, char **argv) {
+	size_t i;
+
+	if (setup()) {
+		fprintf(stderr, "flap-bench: setup failed\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+		if (selected(&benchmarks[i], argc, argv))
+			run(&benchmarks[i]);
+
+	endwin();
+	return 0;
+}
@@ -0,0 +1,295 @@
+/**
+ * @file
+ *
+ * Asynchronous asciicast recorder. See cast.h.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cast.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** What goes into the ring ahead of every event's bytes. */
+typedef struct cast_event {
+	/* Nanoseconds since the recording started. */
+	int64_t ns;
+
+	/* Number of bytes that follow. */
+	uint32_t len;
+
+	/* 'o' for output, 'r' for a resize to "COLSxROWS". */
+	uint32_t kind;
+} cast_event;
+
+//------------------------------ Global Constants -----------------------------
+
+/** First thing the recording shows: hide the cursor. */
+static const char CAST_HELLO[] = "\\u001b[?25l";
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Gets the time since the recording started, in nanoseconds.
+ */
+static int64_t elapsed_ns(const struct timespec *start) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) (now.tv_sec - start->tv_sec) * 1000000000 +
+			(now.tv_nsec - start->tv_nsec);
+}
+
+/**
+ * Copies bytes into the ring at the given position, wrapping around.
+ */
+static void ring_write(cast_recorder *rec, size_t pos, const void *data,
+		size_t len) {
+	size_t at = pos & (CAST_RING - 1);
+	size_t first = len < CAST_RING - at ? len : CAST_RING - at;
+
+	memcpy(&rec->ring[at], data, first);
+	memcpy(rec->ring, (const char *) data + first, len - first);
+}
+
+/**
+ * Copies bytes out of the ring from the given position, wrapping around.
+ */
+static void ring_read(const cast_recorder *rec, size_t pos, void *data,
+		size_t len) {
+	size_t at = pos & (CAST_RING - 1);
+	size_t first = len < CAST_RING - at ? len : CAST_RING - at;
+
+	memcpy(data, &rec->ring[at], first);
+	memcpy((char *) data + first, rec->ring, len - first);
+}
+
+/**
+ * Wakes the writer if it's waiting for events. Costs the game thread a load
+ * when the writer is busy; it takes the lock only when the writer sleeps.
+ */
+static void wake_writer(cast_recorder *rec) {
+	if (!atomic_load(&rec->waiting))
+		return;
+	pthread_mutex_lock(&rec->lock);
+	pthread_cond_signal(&rec->wake);
+	pthread_mutex_unlock(&rec->lock);
+}
+
+/**
+ * Waits until there is an event past 'head' or the recording is done.
+ *
+ * The writer announces it is waiting before looking at 'tail' one last
+ * time, and the game thread stores 'tail' before looking at 'waiting', so
+ * one of them always sees the other: an event is never left in the ring
+ * with the writer asleep.
+ */
+static void wait_for_events(cast_recorder *rec, size_t head) {
+	pthread_mutex_lock(&rec->lock);
+	atomic_store(&rec->waiting, 1);
+	while (head == atomic_load(&rec->tail) && !atomic_load(&rec->done))
+		pthread_cond_wait(&rec->wake, &rec->lock);
+	atomic_store(&rec->waiting, 0);
+	pthread_mutex_unlock(&rec->lock);
+}
+
+/**
+ * Queues an event for the writer. Never blocks: if the ring is too full
+ * the event is dropped.
+ *
+ * @return 0 on success, -1 if the event was dropped.
+ */
+static int push_event(cast_recorder *rec, int kind, const char *data,
+		size_t len) {
+	size_t tail = atomic_load_explicit(&rec->tail, memory_order_relaxed);
+	size_t head = atomic_load_explicit(&rec->head, memory_order_acquire);
+	cast_event ev;
+
+	if (sizeof(ev) + len > CAST_RING - (tail - head))
+		return -1;
+
+	ev.ns = elapsed_ns(&rec->start);
+	ev.len = len;
+	ev.kind = kind;
+	ring_write(rec, tail, &ev, sizeof(ev));
+	ring_write(rec, tail + sizeof(ev), data, len);
+	atomic_store(&rec->tail, tail + sizeof(ev) + len);
+	wake_writer(rec);
+	return 0;
+}
+
+/**
+ * Appends bytes to a buffer as the inside of a JSON string.
+ */
+static void json_escape(outbuf *out, const char *data, size_t len) {
+	char esc[8];
+	size_t i, start;
+
+	for (i = start = 0; i < len; i++) {
+		unsigned char c = data[i];
+		if (c >= 0x20 && c != '"' && c != '\\')
+			continue;
+		outbuf_put(out, &data[start], i - start);
+		if (c == '"' || c == '\\')
+			snprintf(esc, sizeof(esc), "\\%c", c);
+		else
+			snprintf(esc, sizeof(esc), "\\u%04x", c);
+		outbuf_puts(out, esc);
+		start = i + 1;
+	}
+	outbuf_put(out, &data[start], len - start);
+}
+
+/**
+ * The writer thread: turns the events in the ring into lines of the
+ * recording until told to stop and the ring is empty.
+ */
+static void *writer(void *arg) {
+	cast_recorder *rec = arg;
+	outbuf data = { NULL, 0, 0, 0 }, line = { NULL, 0, 0, 0 };
+	size_t head = atomic_load_explicit(&rec->head, memory_order_relaxed);
+	char stamp[48];
+	cast_event ev;
+
+	for (;;) {
+		if (head == atomic_load_explicit(&rec->tail, memory_order_acquire)) {
+			if (atomic_load(&rec->done) &&
+					head == atomic_load(&rec->tail))
+				break;
+			fflush(rec->out);
+			wait_for_events(rec, head);
+			continue;
+		}
+
+		ring_read(rec, head, &ev, sizeof(ev));
+		data.len = 0;
+		if (outbuf_reserve(&data, ev.len)) {
+			rec->failed = 1;
+		}
+		else {
+			ring_read(rec, head + sizeof(ev), data.data, ev.len);
+			data.len = ev.len;
+		}
+		atomic_store_explicit(&rec->head, head += sizeof(ev) + ev.len,
+				memory_order_release);
+
+		line.len = 0;
+		snprintf(stamp, sizeof(stamp), "[%.6f, \"%c\", \"", ev.ns / 1e9,
+				(char) ev.kind);
+		outbuf_puts(&line, stamp);
+		json_escape(&line, data.data, data.len);
+		outbuf_puts(&line, "\"]\n");
+		if (line.failed || fwrite(line.data, 1, line.len, rec->out) != line.len)
+			rec->failed = 1;
+	}
+
+	outbuf_free(&data);
+	outbuf_free(&line);
+	return NULL;
+}
+
+/**
+ * Starts recording to a new asciicast file.
+ *
+ * @param[out] rec Recorder to set up.
+ * @param path File to create.
+ * @param rows, cols Size of the terminal being recorded.
+ *
+ * @return 0 on success, -1 with errno set on error.
+ */
+int cast_open(cast_recorder *rec, const char *path, int rows, int cols) {
+	memset(&rec->r, 0, sizeof(rec->r));
+	memset(&rec->scratch, 0, sizeof(rec->scratch));
+	atomic_init(&rec->head, 0);
+	atomic_init(&rec->tail, 0);
+	atomic_init(&rec->done, 0);
+	atomic_init(&rec->waiting, 0);
+	rec->dropped = 0;
+	rec->failed = 0;
+
+	if (!(rec->out = fopen(path, "w")))
+		return -1;
+	if ((errno = pthread_mutex_init(&rec->lock, NULL))) {
+		fclose(rec->out);
+		return -1;
+	}
+	if ((errno = pthread_cond_init(&rec->wake, NULL))) {
+		pthread_mutex_destroy(&rec->lock);
+		fclose(rec->out);
+		return -1;
+	}
+	fprintf(rec->out, "{\"version\": 2, \"width\": %d, \"height\": %d, "
+			"\"timestamp\": %ld}\n", cols, rows, (long) time(NULL));
+	fprintf(rec->out, "[0.000000, \"o\", \"%s\"]\n", CAST_HELLO);
+	clock_gettime(CLOCK_MONOTONIC, &rec->start);
+
+	if (ansi_init(&rec->r, rows, cols) ||
+			(errno = pthread_create(&rec->writer, NULL, writer, rec))) {
+		ansi_free(&rec->r);
+		pthread_cond_destroy(&rec->wake);
+		pthread_mutex_destroy(&rec->lock);
+		fclose(rec->out);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Records a frame: queues the escape sequences that turn the last frame
+ * recorded into this one. A frame that looks the same as the last one
+ * queues nothing. A frame of a new size is recorded as a resize and a full
+ * repaint.
+ */
+void cast_frame(cast_recorder *rec, const cellbuf *frame) {
+	char size[32];
+	int len;
+
+	if (frame->rows != rec->r.front.rows || frame->cols != rec->r.front.cols) {
+		len = snprintf(size, sizeof(size), "%dx%d", frame->cols, frame->rows);
+		if (push_event(rec, 'r', size, len) ||
+				ansi_resize(&rec->r, frame->rows, frame->cols)) {
+			rec->dropped++;
+			return; // Try again with the next frame.
+		}
+	}
+
+	rec->scratch.len = 0;
+	rec->scratch.failed = 0;
+	ansi_flush(&rec->r, frame, &rec->scratch);
+	if (!rec->scratch.failed && rec->scratch.len == 0)
+		return;
+	if (rec->scratch.failed ||
+			push_event(rec, 'o', rec->scratch.data, rec->scratch.len)) {
+		// The recording lost track of the screen; repaint it next time.
+		rec->dropped++;
+		ansi_invalidate(&rec->r);
+	}
+}
+
+/**
+ * Stops recording once the writer has written out every frame queued.
+ *
+ * @return 0 on success, -1 if some of the recording couldn't be written.
+ */
+int cast_close(cast_recorder *rec) {
+	int status;
+
+	atomic_store(&rec->done, 1);
+	pthread_mutex_lock(&rec->lock);
+	pthread_cond_signal(&rec->wake);
+	pthread_mutex_unlock(&rec->lock);
+	pthread_join(rec->writer, NULL);
+	pthread_cond_destroy(&rec->wake);
+	pthread_mutex_destroy(&rec->lock);
+	status = rec->failed || ferror(rec->out) ? -1 : 0;
+	if (fclose(rec->out))
+		status = -1;
+	ansi_free(&rec->r);
+	outbuf_free(&rec->scratch);
+	return status;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file
+ *
+ * Screen recorder for --cast: writes the frames the game shows to an
+ * asciicast v2 file, which asciinema can play back or turn into a GIF.
+ *
+ * The game thread only diffs each frame against the last one with the ANSI
+ * emitter and copies the escape sequences into a lock-free single-producer
+ * single-consumer ring. A writer thread of its own takes them out, turns
+ * them into asciicast events and does all the disk I/O, so a slow disk
+ * never holds up a frame. The writer sleeps while the ring is empty, and
+ * the game thread only wakes it when it queues something. If the writer
+ * falls so far behind that the ring fills up, frames are dropped instead
+ * and the next one that fits repaints the whole screen.
+ */
+
+#ifndef CAST_H
+#define CAST_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "ansi.h"
+#include "cellbuf.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Bytes of frame data the ring holds. Must be a power of two. */
+#define CAST_RING 262144
+
+/** A recording in progress. */
+typedef struct cast_recorder {
+	FILE *out;
+	pthread_t writer;
+
+	/* When the recording started; event times count from here. */
+	struct timespec start;
+
+	/*
+	 * Game thread side: what the recording shows, and the current frame's
+	 * escape sequences before they go into the ring.
+	 */
+	ansi_renderer r;
+	outbuf scratch;
+
+	/*
+	 * The ring of events. The game thread appends at 'tail' and the writer
+	 * takes them from 'head'; both only ever grow, and are taken modulo
+	 * CAST_RING.
+	 */
+	char ring[CAST_RING];
+	atomic_size_t head, tail;
+
+	/* Set when the recording should end. */
+	atomic_int done;
+
+	/*
+	 * Set while the writer waits on 'wake' for the ring to fill; the game
+	 * thread only takes 'lock' to signal it then.
+	 */
+	atomic_int waiting;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+
+	/* Frames dropped because the ring was full. */
+	long dropped;
+
+	/* Nonzero if the writer failed to write the file. */
+	int failed;
+} cast_recorder;
+
+//---------------------------------- Functions --------------------------------
+
+int cast_open(cast_recorder *rec, const char *path, int rows, int cols);
+void cast_frame(cast_recorder *rec, const cellbuf *frame);
+int cast_close(cast_recorder *rec);
+
+#endif
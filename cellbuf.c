@@ -0,0 +1,197 @@
+/**
+ * @file
+ *
+ * Off-screen grid of character cells. See cellbuf.h.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cellbuf.h"
+
+/** What each glyph looks like in UTF-8, and in ASCII. */
+static const char *const GLYPH_UTF8[GLYPH_END - GLYPH_FIRST] = {
+	"\xe2\x96\x80", "\xe2\x96\x84"
+};
+static const char GLYPH_ASCII[GLYPH_END - GLYPH_FIRST] = { '0', '0' };
+
+/**
+ * Allocates a blank grid.
+ *
+ * @param[out] cb Grid to initialize.
+ * @param rows
+ * @param cols
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int cellbuf_init(cellbuf *cb, int rows, int cols) {
+	cb->rows = rows;
+	cb->cols = cols;
+	cb->cells = malloc(rows * cols);
+	if (!cb->cells)
+		return -1;
+	cellbuf_clear(cb);
+	return 0;
+}
+
+/**
+ * Changes the size of a grid, e.g. after the terminal was resized. The
+ * contents are blanked.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int cellbuf_resize(cellbuf *cb, int rows, int cols) {
+	char *cells = realloc(cb->cells, rows * cols);
+	if (!cells)
+		return -1;
+	cb->cells = cells;
+	cb->rows = rows;
+	cb->cols = cols;
+	cellbuf_clear(cb);
+	return 0;
+}
+
+/**
+ * Releases the memory held by a grid.
+ */
+void cellbuf_free(cellbuf *cb) {
+	free(cb->cells);
+	cb->cells = NULL;
+	cb->rows = cb->cols = 0;
+}
+
+/**
+ * Gets the UTF-8 encoding of a cell holding a glyph. Cells that hold ASCII
+ * characters stand for themselves.
+ *
+ * @return The glyph as a string, or "?" if it isn't one.
+ */
+const char *cell_utf8(char ch) {
+	unsigned char c = ch;
+
+	return c >= GLYPH_FIRST && c < GLYPH_END ? GLYPH_UTF8[c - GLYPH_FIRST] :
+			"?";
+}
+
+/**
+ * Gets the ASCII character to show for a cell on terminals that can't show
+ * glyphs.
+ */
+char cell_ascii(char ch) {
+	unsigned char c = ch;
+
+	if (c < GLYPH_FIRST)
+		return ch;
+	return c < GLYPH_END ? GLYPH_ASCII[c - GLYPH_FIRST] : '?';
+}
+
+/**
+ * Blanks every cell.
+ */
+void cellbuf_clear(cellbuf *cb) {
+	memset(cb->cells, ' ', cb->rows * cb->cols);
+}
+
+/**
+ * Writes one char. Cells outside the grid are silently dropped, which lets
+ * callers draw sprites that are partially off-screen.
+ */
+void cellbuf_put(cellbuf *cb, int row, int col, char ch) {
+	if (row >= 0 && row < cb->rows && col >= 0 && col < cb->cols)
+		CELL(cb, row, col) = ch;
+}
+
+/**
+ * Clips the horizontal span [*col, *col + *len) of the given row to the
+ * grid.
+ *
+ * @return 1 if anything is left to draw, 0 otherwise.
+ */
+static int clip_span(const cellbuf *cb, int row, int *col, int *len) {
+	if (row < 0 || row >= cb->rows)
+		return 0;
+	if (*col < 0) {
+		*len += *col;
+		*col = 0;
+	}
+	if (*col + *len > cb->cols)
+		*len = cb->cols - *col;
+	return *len > 0;
+}
+
+/**
+ * Writes 'len' copies of a char left to right starting at the given cell,
+ * clipped to the grid.
+ */
+void cellbuf_hline(cellbuf *cb, int row, int col, int len, char ch) {
+	if (clip_span(cb, row, &col, &len))
+		memset(&CELL(cb, row, col), ch, len);
+}
+
+/**
+ * Writes 'len' copies of a char top to bottom starting at the given cell,
+ * clipped to the grid.
+ */
+void cellbuf_vline(cellbuf *cb, int row, int col, int len, char ch) {
+	char *cell;
+
+	if (col < 0 || col >= cb->cols)
+		return;
+	if (row < 0) {
+		len += row;
+		row = 0;
+	}
+	if (row + len > cb->rows)
+		len = cb->rows - row;
+	for (cell = &CELL(cb, row, col); len > 0; len--, cell += cb->cols)
+		*cell = ch;
+}
+
+/**
+ * Writes a char into every 'spacing'-th cell of the columns [col, end) of
+ * the given row, clipped to the grid.
+ */
+void cellbuf_dotted(cellbuf *cb, int row, int col, int end, int spacing,
+		char ch) {
+	char *cell, *stop;
+	int len = end - col;
+
+	if (col < 0) {
+		// Keep the phase of the pattern when clipping the left edge.
+		int skip = (-col + spacing - 1) / spacing * spacing;
+		col += skip;
+		len -= skip;
+	}
+	if (!clip_span(cb, row, &col, &len))
+		return;
+	stop = &CELL(cb, row, col) + len;
+	for (cell = &CELL(cb, row, col); cell < stop; cell += spacing)
+		*cell = ch;
+}
+
+/**
+ * Writes a string left to right starting at the given cell. The string is
+ * taken literally (no format directives) and clipped to the grid.
+ */
+void cellbuf_puts(cellbuf *cb, int row, int col, const char *str) {
+	int len = strlen(str);
+	int skip = col < 0 ? -col : 0;
+
+	if (clip_span(cb, row, &col, &len))
+		memcpy(&CELL(cb, row, col), str + skip, len);
+}
+
+/**
+ * Writes printf-style formatted text starting at the given cell.
+ */
+void cellbuf_printf(cellbuf *cb, int row, int col, const char *fmt, ...) {
+	char line[256];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	cellbuf_puts(cb, row, col, line);
+}
@@ -0,0 +1,49 @@
+/**
+ * @file
+ *
+ * Off-screen grid of character cells. Frames are composed here instead of
+ * directly on the terminal so the renderer can compare consecutive frames
+ * and only send the cells that changed.
+ */
+
+#ifndef CELLBUF_H
+#define CELLBUF_H
+
+/**
+ * Cells hold ASCII characters or, from GLYPH_FIRST on, one of these block
+ * glyphs, which draw at a finer grain than a cell. Front ends send them to
+ * the terminal as UTF-8, or as an ASCII stand-in if they can't.
+ */
+enum cell_glyph {
+	GLYPH_FIRST = 0x80,
+	GLYPH_UPPER_HALF = GLYPH_FIRST,  // U+2580, the top half of the cell.
+	GLYPH_LOWER_HALF,                // U+2584, the bottom half of the cell.
+	GLYPH_END
+};
+
+/** A rows x cols grid of characters, stored row-major. */
+typedef struct cellbuf {
+	int rows;
+	int cols;
+	char *cells;
+} cellbuf;
+
+int cellbuf_init(cellbuf *cb, int rows, int cols);
+int cellbuf_resize(cellbuf *cb, int rows, int cols);
+void cellbuf_free(cellbuf *cb);
+const char *cell_utf8(char ch);
+char cell_ascii(char ch);
+void cellbuf_clear(cellbuf *cb);
+void cellbuf_put(cellbuf *cb, int row, int col, char ch);
+void cellbuf_hline(cellbuf *cb, int row, int col, int len, char ch);
+void cellbuf_vline(cellbuf *cb, int row, int col, int len, char ch);
+void cellbuf_dotted(cellbuf *cb, int row, int col, int end, int spacing,
+		char ch);
+void cellbuf_puts(cellbuf *cb, int row, int col, const char *str);
+void cellbuf_printf(cellbuf *cb, int row, int col, const char *fmt, ...)
+		__attribute__((format(printf, 4, 5)));
+
+/** Gets the cell at the given row and column; no bounds checking. */
+#define CELL(cb, row, col) ((cb)->cells[(row) * (cb)->cols + (col)])
+
+#endif
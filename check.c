@@ -0,0 +1,583 @@
+/**
+ * @file
+ *
+ * Checks that the game still plays the way it should, for catching
+ * regressions: run with "make check". Every check plays some games headless
+ * and compares them with what they should have done, and prints what went
+ * wrong if they didn't.
+ *
+ * Usage: flap-check [NAME]... runs only the checks whose names contain one
+ * of the given words.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "corpus.h"
+#include "profile.h"
+#include "replay.h"
+#include "sim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** A check: returns the number of things that went wrong. */
+typedef struct check {
+	const char *name;
+	int (*run)(void);
+} check;
+
+/** A game for the replay checks to record. */
+typedef struct recorded_game {
+	int rows, cols;
+	unsigned int seed;
+
+	/* Frames to play at most, and nonzero to play with batch_policy(). */
+	int max_frames;
+	int flaps;
+} recorded_game;
+
+//------------------------------ Global Constants -----------------------------
+
+/**
+ * Games the replay checks record: some that batch_policy() plays until it
+ * dies or quits, and one that only falls, on a board so tall that its one
+ * run of INPUT_NONE takes more than one byte.
+ */
+static const recorded_game GAMES[] = {
+	{ 24, 80, 1, 3000, 1 },
+	{ 16, 48, 2, 3000, 1 },
+	{ 12, 30, 3, 3000, 1 },
+	{ 1000, 1000, 4, 3000, 0 }
+};
+
+/** Number of games in GAMES. */
+#define NUM_GAMES ((int) (sizeof(GAMES) / sizeof(GAMES[0])))
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Creates an empty temporary file for a check.
+ *
+ * @param[out] path Receives the file's name; at least 32 bytes.
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int temp_file(char *path) {
+	int fd;
+
+	strcpy(path, "/tmp/flap-check-XXXXXX");
+	if ((fd = mkstemp(path)) < 0) {
+		perror("  mkstemp");
+		return -1;
+	}
+	close(fd);
+	return 0;
+}
+
+/**
+ * Plays the games in GAMES and records them to a new replay file.
+ *
+ * @param path Replay file to create; it must be empty or not exist.
+ * @param[out] played Receives how each game ended: its score, and how many
+ * frames it was recorded for.
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int record_games(const char *path, episode_result *played) {
+	static replay_writer w;
+	game_state s;
+	int g, f, input;
+
+	if (replay_open(&w, path)) {
+		perror("  replay_open");
+		return -1;
+	}
+	for (g = 0; g < NUM_GAMES; g++) {
+		sim_init(&s, GAMES[g].rows, GAMES[g].cols, GAMES[g].seed);
+		replay_begin(&w, &s);
+		for (f = 0; f < GAMES[g].max_frames && !s.dead; f++) {
+			input = GAMES[g].flaps ? batch_policy(&s) : INPUT_NONE;
+			sim_step(&s, input);
+			replay_frame(&w, input);
+		}
+		played[g].score = s.score;
+		played[g].frames = f;
+		if (replay_end(&w, &s)) {
+			perror("  replay_end");
+			replay_close(&w);
+			return -1;
+		}
+	}
+	return replay_close(&w);
+}
+
+/**
+ * Checks the episode read back from a recording against how the game was
+ * played, and that it replays the same way.
+ *
+ * @return The number of things that went wrong.
+ */
+static int check_episode(const char *what, int g, const replay_episode *ep,
+		const episode_result *played) {
+	game_state s;
+	int status;
+
+	if ((int) ep->frames != played->frames ||
+			(int) ep->score != played->score) {
+		printf("  %s %d: recorded score %u in %u frames, played score %d in "
+				"%d frames\n", what, g, ep->score, ep->frames, played->score,
+				played->frames);
+		return 1;
+	}
+	if ((status = replay_play(ep, &s)) != 0) {
+		printf("  %s %d: replay_play() says %d, replayed score %d\n", what,
+				g, status, s.score);
+		return 1;
+	}
+	return 0;
+}
+
+
+/**
+ * Plays batches on the lockstep engine, through batch_run(), and every
+ * episode again through batch_episode(), which plays it on sim_step(), on
+ * boards both roomy and cramped enough for the policy to die: every episode
+ * has to end on the same frame with the same score.
+ */
+static int check_lockstep(void) {
+	static const int BOARDS[][2] = { { 24, 80 }, { 16, 48 }, { 12, 30 } };
+	batch_config cfg;
+	episode_result *fast, slow;
+	int b, i, deaths = 0, bad = 0;
+
+	cfg.episodes = 600;
+	cfg.threads = 3;
+	cfg.max_frames = 20000;
+	cfg.seed = 1;
+	cfg.scroll = 1;
+	cfg.profile = NULL;
+	cfg.policy = batch_policy;
+	if (!(fast = calloc(cfg.episodes, sizeof(*fast))))
+		return 1;
+
+	for (b = 0; b < (int) (sizeof(BOARDS) / sizeof(BOARDS[0])); b++) {
+		cfg.rows = BOARDS[b][0];
+		cfg.cols = BOARDS[b][1];
+		if (batch_run(&cfg, fast)) {
+			free(fast);
+			return 1;
+		}
+		for (i = 0; i < cfg.episodes; i++) {
+			batch_episode(&cfg, i, &slow);
+			deaths += slow.frames < cfg.max_frames;
+			if (fast[i].score != slow.score || fast[i].frames != slow.frames) {
+				printf("  %dx%d episode %d: lockstep score %d in %d frames, "
+						"sim_step score %d in %d frames\n", cfg.cols, cfg.rows,
+						i, fast[i].score, fast[i].frames, slow.score,
+						slow.frames);
+				bad++;
+			}
+		}
+	}
+	if (deaths == 0) {
+		printf("  no episode died, so no death frame was compared\n");
+		bad++;
+	}
+	free(fast);
+	return bad;
+}
+
+/**
+ * Scrolls the pipes until the score reaches 'score', then checks that the
+ * pool holds as many pipes as the spacing asks for and that neighbouring
+ * pipes are 'spacing' columns apart.
+ *
+ * @return The number of things that went wrong.
+ */
+static int pipes_spaced(game_state *s, int score, int spacing, int count) {
+	int i, gap, bad = 0;
+
+	while (s->score < score)
+		pipe_refresh(s);
+	if (s->pipes.count != count) {
+		printf("  score %d: %d pipes in the pool, not %d\n", s->score,
+				s->pipes.count, count);
+		bad++;
+	}
+	for (i = 1; i < s->pipes.count; i++) {
+		gap = POOL_PIPE(&s->pipes, i).center -
+				POOL_PIPE(&s->pipes, i - 1).center;
+		if (gap != spacing) {
+			printf("  score %d: pipes %d and %d are %d columns apart, "
+					"not %d\n", s->score, i - 1, i, gap, spacing);
+			bad++;
+		}
+	}
+	return bad;
+}
+
+/**
+ * Follows a profile whose spacing drops from 44 to 20 and later goes back
+ * up to 44: once the pipes from before each change are gone, the pool has
+ * to have grown or shrunk to match, with every pipe at the new spacing.
+ */
+static int check_spacing(void) {
+	static profile prof;
+	game_state s;
+	int i, bad = 0;
+
+	for (i = 0; i < PROFILE_LEVELS; i++) {
+		prof.levels[i].opening_width = OPENING_WIDTH;
+		prof.levels[i].opening_low = 0.25f;
+		prof.levels[i].opening_range = 0.5f;
+		prof.levels[i].spacing = i >= 5 && i < 20 ? 20 : 44;
+		prof.levels[i].scroll = 1;
+	}
+
+	// 80 columns and the stretch off either edge take 5 pipes 20 columns
+	// apart, or 2 pipes 44 apart.
+	sim_init(&s, 24, 80, 1);
+	sim_set_profile(&s, &prof);
+	bad += pipes_spaced(&s, 4, 44, 2);
+	bad += pipes_spaced(&s, 15, 20, 5);
+	bad += pipes_spaced(&s, 30, 44, 2);
+	return bad;
+}
+
+/**
+ * Starts a game whose pipes move 'scroll' columns a frame, with the first
+ * pipe centered on column 'center' and its opening either around Flappy or
+ * well clear of him.
+ */
+static void swept_setup(game_state *s, int scroll, int center,
+		int in_opening) {
+	pipe_pool *pool = &s->pipes;
+	vpipe *p;
+	int i, h, shift;
+
+	sim_init(s, 24, 80, 1);
+	sim_set_scroll(s, scroll);
+	shift = center - POOL_PIPE(pool, 0).center;
+	for (i = 0; i < pool->count; i++)
+		POOL_PIPE(pool, i).center += shift;
+
+	h = get_flappy_position(s->bird);
+	p = &POOL_PIPE(pool, 0);
+	p->opening_height = in_opening ? (h + 0.5f) / (s->rows - 1) :
+			h < s->rows / 2 ? 0.8f : 0.2f;
+	pipe_shape(p, s->rows);
+}
+
+/**
+ * Moves pipes so fast that one frame carries the first of them from right
+ * of Flappy's column to left of it: Flappy never shares a column with it
+ * at the start or end of the frame, so only the swept collision of
+ * sim_step() can see him crash into it. He has to crash into it when it
+ * passes him by, and fly through it when he's in the opening.
+ */
+static int check_swept(void) {
+	static const int SCROLLS[] = { 10, 20, 40 };
+	int center = FLAPPY_COL + PIPE_RADIUS + 2;
+	game_state s;
+	size_t i;
+	int bad = 0;
+
+	for (i = 0; i < sizeof(SCROLLS) / sizeof(SCROLLS[0]); i++) {
+		swept_setup(&s, SCROLLS[i], center, 0);
+		sim_step(&s, INPUT_NONE);
+		if (crashed_into_pipes(get_flappy_position(s.bird), &s.pipes, 0)) {
+			printf("  scroll %d: the pipe didn't get past Flappy in one "
+					"frame\n", SCROLLS[i]);
+			bad++;
+		}
+		if (!s.dead) {
+			printf("  scroll %d: Flappy flew through a pipe\n", SCROLLS[i]);
+			bad++;
+		}
+
+		swept_setup(&s, SCROLLS[i], center, 1);
+		sim_step(&s, INPUT_NONE);
+		if (s.dead) {
+			printf("  scroll %d: Flappy crashed in the opening\n",
+					SCROLLS[i]);
+			bad++;
+		}
+	}
+	return bad;
+}
+
+/**
+ * Writes a profile to a temporary file and reads it back with
+ * profile_load(), which it takes its arguments and return value from.
+ * Fails with *line -1 if the file can't be written.
+ */
+static int load_profile_text(const char *text, profile *p, int *line) {
+	char path[32];
+	FILE *out;
+	int ret, err;
+
+	*line = -1;
+	if (temp_file(path))
+		return -1;
+	if (!(out = fopen(path, "w")) || fputs(text, out) == EOF ||
+			fclose(out)) {
+		perror("  profile file");
+		unlink(path);
+		return -1;
+	}
+	ret = profile_load(p, path, line);
+	err = errno;
+	unlink(path);
+	errno = err;
+	return ret;
+}
+
+/**
+ * Feeds profile_load() profiles that don't make sense, which it has to
+ * reject with the line at fault, and ones that do, whose table has to hold
+ * the curves' values at every score, or the classic ones where a curve is
+ * left out.
+ */
+static int check_profile(void) {
+	static const struct {
+		const char *text;
+		int line;
+	} BAD[] = {
+		{ "opening 0:9 40\n", 1 },
+		{ "opening 0:9 x:5\n", 1 },
+		{ "opening 0:9 40:5z\n", 1 },
+		{ "opening\n", 1 },
+		{ "# Too wide.\nspacing 0:44\nopening 0:99\n", 3 },
+		{ "scroll 0:0\n", 1 },
+		{ "opening-low 0:-0.5\n", 1 },
+		{ "spacing 10:30 5:44\n", 1 },
+		{ "spacing 0:30 0:44\n", 1 },
+		{ "speed 0:1\n", 1 },
+		{ "opening 0:9\nopening 10:5\n", 2 },
+		{ "opening-low 0:0.8\nopening-high 0:0.4\n", 2 }
+	};
+	static const char GOOD[] =
+			"# The example in profile.h.\n"
+			"opening       0:9  40:5\n"
+			"spacing       0:44 40:30\n"
+			"scroll        0:1  59:1 60:2\n"
+			"opening-low   0:0.25\n"
+			"opening-high  0:0.75\n";
+	static const struct {
+		const char *text;
+		int score;
+		profile_level lv;
+	} LEVELS[] = {
+		{ GOOD, 0,   { 9, 0.25f, 0.5f, 44, 1 } },
+		{ GOOD, 10,  { 8, 0.25f, 0.5f, 41, 1 } },
+		{ GOOD, 20,  { 7, 0.25f, 0.5f, 37, 1 } },
+		{ GOOD, 59,  { 5, 0.25f, 0.5f, 30, 1 } },
+		{ GOOD, 60,  { 5, 0.25f, 0.5f, 30, 2 } },
+		{ GOOD, 300, { 5, 0.25f, 0.5f, 30, 2 } },
+		{ "\n# Classic.\n", 0,
+				{ SIM_OPENING_WIDTH, 0.25f, 0.5f, SIM_PIPE_SPACING, 1 } },
+		{ "opening-high 0:0.75 100:0.5 # Lower and lower.\n", 50,
+				{ SIM_OPENING_WIDTH, 0.25f, 0.375f, SIM_PIPE_SPACING, 1 } }
+	};
+	static profile prof;
+	const profile_level *got, *want;
+	size_t i;
+	int line, bad = 0;
+
+	for (i = 0; i < sizeof(BAD) / sizeof(BAD[0]); i++) {
+		if (!load_profile_text(BAD[i].text, &prof, &line)) {
+			printf("  bad profile %zu was taken\n", i);
+			bad++;
+		}
+		else if (errno != EINVAL || line != BAD[i].line) {
+			printf("  bad profile %zu: line %d, errno %d, not line %d, "
+					"EINVAL\n", i, line, errno, BAD[i].line);
+			bad++;
+		}
+	}
+
+	for (i = 0; i < sizeof(LEVELS) / sizeof(LEVELS[0]); i++) {
+		if (load_profile_text(LEVELS[i].text, &prof, &line)) {
+			printf("  profile %zu rejected at line %d\n", i, line);
+			bad++;
+			continue;
+		}
+		got = profile_at(&prof, LEVELS[i].score);
+		want = &LEVELS[i].lv;
+		if (got->opening_width != want->opening_width ||
+				got->opening_low != want->opening_low ||
+				got->opening_range != want->opening_range ||
+				got->spacing != want->spacing || got->scroll != want->scroll) {
+			printf("  profile %zu, score %d: opening %d at %g+%g, spacing "
+					"%d, scroll %d\n", i, LEVELS[i].score,
+					got->opening_width, got->opening_low, got->opening_range,
+					got->spacing, got->scroll);
+			bad++;
+		}
+	}
+	return bad;
+}
+
+/**
+ * Records some games to a replay file, reads it back and replays every
+ * episode: each has to end with the score it was recorded with, on the
+ * frame it was recorded on. The falling game's run has to take more than a
+ * byte, so the varint encoding is covered.
+ */
+static int check_replay(void) {
+	episode_result played[NUM_GAMES];
+	replay_episode ep;
+	unsigned char *data;
+	char path[32];
+	size_t len, pos, n;
+	int g, bad = 0;
+
+	if (temp_file(path))
+		return 1;
+	if (record_games(path, played) ||
+			!(data = replay_read_file(path, &len))) {
+		unlink(path);
+		return 1;
+	}
+	unlink(path);
+
+	if (replay_check_header(data, len)) {
+		printf("  the recording has no valid header\n");
+		free(data);
+		return 1;
+	}
+	for (g = 0, pos = REPLAY_HEADER_LEN; pos < len; g++, pos += n) {
+		if (!(n = replay_parse(data + pos, len - pos, &ep))) {
+			printf("  episode %d doesn't parse\n", g);
+			bad++;
+			break;
+		}
+		if (g >= NUM_GAMES)
+			continue;
+		bad += check_episode("episode", g, &ep, &played[g]);
+		if (!GAMES[g].flaps && (ep.runs_len < 2 || !(ep.runs[0] & 0x80))) {
+			printf("  episode %d: a run of %u frames took one byte\n", g,
+					ep.frames);
+			bad++;
+		}
+	}
+	if (g != NUM_GAMES) {
+		printf("  read back %d episodes, not %d\n", g, NUM_GAMES);
+		bad++;
+	}
+	free(data);
+	return bad;
+}
+
+/**
+ * Records the games twice, to two replay files, packs both into an archive
+ * and reads it back: it has to hold every episode of both files, in order,
+ * and re-scoring it has to give every game's score and frame count.
+ */
+static int check_corpus(void) {
+	episode_result played[NUM_GAMES];
+	corpus_result *results = NULL;
+	replay_episode ep;
+	char paths[3][32], *inputs[2] = { paths[0], paths[1] };
+	const char *bad;
+	corpus c;
+	int i, g, made = 0, failed = 1, errors = 0;
+
+	for (; made < 3; made++)
+		if (temp_file(paths[made]))
+			goto done;
+	if (record_games(paths[0], played) || record_games(paths[1], played))
+		goto done;
+	if (corpus_pack(paths[2], inputs, 2, &bad) != 2 * NUM_GAMES) {
+		printf("  corpus_pack() didn't pack %d episodes\n", 2 * NUM_GAMES);
+		goto done;
+	}
+	if (corpus_open(&c, paths[2])) {
+		perror("  corpus_open");
+		goto done;
+	}
+	failed = 0;
+
+	if (c.count != 2 * NUM_GAMES ||
+			!(results = calloc(c.count, sizeof(*results)))) {
+		printf("  the archive holds %zu episodes, not %d\n", c.count,
+				2 * NUM_GAMES);
+		errors++;
+	}
+	else if (corpus_score(&c, 2, results)) {
+		perror("  corpus_score");
+		errors++;
+	}
+	else {
+		for (i = 0; i < (int) c.count; i++) {
+			g = i % NUM_GAMES;
+			if (corpus_episode(&c, i, &ep)) {
+				printf("  archive episode %d doesn't parse\n", i);
+				errors++;
+				continue;
+			}
+			errors += check_episode("archive episode", i, &ep, &played[g]);
+			if (results[i].status != 0 ||
+					results[i].score != played[g].score ||
+					results[i].frames != played[g].frames) {
+				printf("  archive episode %d: re-scored %d in %d frames "
+						"(status %d), played %d in %d frames\n", i,
+						results[i].score, results[i].frames,
+						results[i].status, played[g].score,
+						played[g].frames);
+				errors++;
+			}
+		}
+	}
+	free(results);
+	corpus_close(&c);
+
+done:
+	while (made-- > 0)
+		unlink(paths[made]);
+	return failed + errors;
+}
+
+/** The checks, in the order they run. */
+static const check checks[] = {
+	{ "lockstep", check_lockstep },
+	{ "spacing",  check_spacing },
+	{ "swept",    check_swept },
+	{ "profile",  check_profile },
+	{ "replay",   check_replay },
+	{ "corpus",   check_corpus }
+};
+
+/**
+ * Returns true if the check was asked for on the command line.
+ */
+static int selected(const check *c, int argc, char **argv) {
+	int i;
+
+	if (argc < 2)
+		return 1;
+	for (i = 1; i < argc; i++)
+		if (strstr(c->name, argv[i]))
+			return 1;
+	return 0;
+}
+
+//------------------------------------ Main -----------------------------------
+
+int main(int argc, char **argv) {
+	size_t i;
+	int bad, failed = 0;
+
+	for (i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+		if (!selected(&checks[i], argc, argv))
+			continue;
+		bad = checks[i].run();
+		printf("%-24s %s\n", checks[i].name, bad ? "FAILED" : "ok");
+		failed += bad > 0;
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,372 @@
+/**
+ * @file
+ *
+ * Mapping, scoring and packing replay archives. See corpus.h for the file
+ * format.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "corpus.h"
+
+//------------------------------ Global Constants -----------------------------
+
+static const unsigned char CORPUS_MAGIC[4] = { 'F', 'L', 'P', 'A' };
+
+static const uint32_t CORPUS_VERSION = 1;
+
+/** Size of the header at the start of every archive. */
+#define CORPUS_HEADER_LEN 16
+
+//-------------------------------- Definitions --------------------------------
+
+/** An archive being scored, for corpus_score(). */
+typedef struct score_set {
+	const corpus *c;
+	corpus_result *results;
+} score_set;
+
+//---------------------------------- Functions --------------------------------
+
+static void put_u32(unsigned char *p, uint32_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static void put_u64(unsigned char *p, uint64_t v) {
+	put_u32(p, v);
+	put_u32(p + 4, v >> 32);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+	return get_u32(p) | (uint64_t) get_u32(p + 4) << 32;
+}
+
+/**
+ * Maps a whole file into memory, read-only.
+ *
+ * @param path
+ * @param[out] len Receives the size of the file.
+ *
+ * @return The mapping, or NULL with errno set on error. Empty files are an
+ * error, since they can't be mapped.
+ */
+static const unsigned char *map_file(const char *path, size_t *len) {
+	struct stat st;
+	void *data;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st)) {
+		close(fd);
+		return NULL;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // The mapping keeps the file open.
+	if (data == MAP_FAILED)
+		return NULL;
+	*len = st.st_size;
+	return data;
+}
+
+/**
+ * Maps an archive into memory and checks its header and index.
+ *
+ * @param[out] c Archive to set up.
+ * @param path
+ *
+ * @return 0 on success, -1 with errno set if the file couldn't be mapped or
+ * isn't an archive.
+ */
+int corpus_open(corpus *c, const char *path) {
+	uint64_t count;
+
+	if (!(c->data = map_file(path, &c->len)))
+		return -1;
+	if (c->len < CORPUS_HEADER_LEN || memcmp(c->data, CORPUS_MAGIC, 4) ||
+			get_u32(c->data + 4) != CORPUS_VERSION)
+		goto invalid;
+
+	count = get_u64(c->data + 8);
+	if (count > INT_MAX || count > (c->len - CORPUS_HEADER_LEN) / 8)
+		goto invalid;
+	c->count = count;
+	c->index = c->data + CORPUS_HEADER_LEN;
+
+	// Scoring reads the whole archive, so have the kernel read ahead.
+	madvise((void *) c->data, c->len, MADV_WILLNEED);
+	return 0;
+
+invalid:
+	corpus_close(c);
+	errno = EINVAL;
+	return -1;
+}
+
+/**
+ * Unmaps an archive. Episodes taken from it are no longer valid.
+ */
+void corpus_close(corpus *c) {
+	munmap((void *) c->data, c->len);
+	c->data = NULL;
+	c->len = 0;
+	c->count = 0;
+}
+
+/**
+ * Gets an episode of an archive. The episode points into the mapping;
+ * nothing is copied.
+ *
+ * @param c
+ * @param i Episode number, less than c->count.
+ * @param[out] ep Receives the episode.
+ *
+ * @return 0 on success, -1 if the episode's record is garbled.
+ */
+int corpus_episode(const corpus *c, size_t i, replay_episode *ep) {
+	uint64_t off = get_u64(c->index + 8 * i);
+
+	if (off >= c->len || !replay_parse(c->data + off, c->len - off, ep))
+		return -1;
+	return 0;
+}
+
+static void score_job(void *arg, int i) {
+	score_set *set = arg;
+	corpus_result *r = &set->results[i];
+	replay_episode ep;
+	game_state s;
+
+	r->frames = 0;
+	r->score = 0;
+	if (corpus_episode(set->c, i, &ep)) {
+		r->status = -1;
+		return;
+	}
+
+	r->status = replay_play(&ep, &s);
+	if (r->status >= 0) {
+		r->frames = s.frame + s.dead;
+		r->score = s.score;
+	}
+}
+
+/**
+ * Replays every episode of an archive headless on a pool of worker threads
+ * and checks each against how it was recorded.
+ *
+ * @param c Archive to score.
+ * @param threads Number of worker threads.
+ * @param[out] results One entry per episode, filled in by episode number.
+ *
+ * @return 0 on success, -1 if the worker threads couldn't be started.
+ */
+int corpus_score(const corpus *c, int threads, corpus_result *results) {
+	score_set set = { c, results };
+	return batch_for(c->count, threads, score_job, &set);
+}
+
+/**
+ * Walks the episode records of a mapped replay file, calling back with the
+ * size of each.
+ *
+ * @return 0 on success, -1 if the file isn't a replay file or a record is
+ * garbled.
+ */
+static int walk_replay(const unsigned char *data, size_t len,
+		int (*record)(void *arg, size_t len), void *arg) {
+	replay_episode ep;
+	size_t off, n;
+
+	if (replay_check_header(data, len))
+		return -1;
+	for (off = REPLAY_HEADER_LEN; off < len; off += n)
+		if (!(n = replay_parse(data + off, len - off, &ep)) ||
+				record(arg, n))
+			return -1;
+	return 0;
+}
+
+/** Sizes of the records going into an archive, for the first pass. */
+typedef struct record_list {
+	uint64_t *sizes;
+	size_t count, cap;
+
+	/* Nonzero if memory for the sizes ran out. */
+	int failed;
+} record_list;
+
+static int list_record(void *arg, size_t len) {
+	record_list *list = arg;
+
+	if (list->count == list->cap) {
+		size_t cap = list->cap ? 2 * list->cap : 1024;
+		uint64_t *sizes = realloc(list->sizes, cap * sizeof(*sizes));
+		if (!sizes) {
+			list->failed = 1;
+			return -1;
+		}
+		list->sizes = sizes;
+		list->cap = cap;
+	}
+	list->sizes[list->count++] = len;
+	return 0;
+}
+
+/** Records listed in the first pass, as the second pass meets them. */
+typedef struct record_check {
+	const record_list *list;
+	size_t next;
+} record_check;
+
+/**
+ * Checks that the next record is the one the first pass listed, i.e. that
+ * its file didn't change in between.
+ */
+static int check_record(void *arg, size_t len) {
+	record_check *check = arg;
+	return check->next < check->list->count &&
+			check->list->sizes[check->next++] == len ? 0 : -1;
+}
+
+/**
+ * Packs the episodes of some replay files into a new archive, in order.
+ * The files are read twice, once to build the index and once to copy the
+ * records, so that no more than one of them is in memory at a time. The
+ * archive is written to a temporary file next to it and renamed into place
+ * once complete, so a failure leaves whatever was at 'path' alone.
+ *
+ * @param path Archive to create, replacing any existing file.
+ * @param inputs Replay files to pack.
+ * @param n Number of replay files.
+ * @param[out] bad Receives the name of the file at fault on error.
+ *
+ * @return Number of episodes packed, or -1 with errno set on error.
+ */
+int corpus_pack(const char *path, char *const *inputs, int n,
+		const char **bad) {
+	record_list list = { NULL, 0, 0, 0 };
+	record_check check = { &list, 0 };
+	FILE *out = NULL;
+	char *tmp = NULL;
+	unsigned char header[CORPUS_HEADER_LEN], entry[8];
+	const unsigned char *data;
+	uint64_t off;
+	size_t len, i;
+	int f, fd, status, saved;
+
+	for (f = 0; f < n; f++) {
+		*bad = inputs[f];
+		if (!(data = map_file(inputs[f], &len)))
+			goto fail;
+		status = walk_replay(data, len, list_record, &list);
+		munmap((void *) data, len);
+		if (status) {
+			errno = list.failed ? ENOMEM : EINVAL;
+			goto fail;
+		}
+	}
+	if (list.count > INT_MAX) {
+		errno = EFBIG;
+		goto fail;
+	}
+
+	*bad = path;
+	if (!(tmp = malloc(strlen(path) + 8)))
+		goto fail;
+	sprintf(tmp, "%s.XXXXXX", path);
+	if ((fd = mkstemp(tmp)) < 0) {
+		free(tmp);
+		tmp = NULL;
+		goto fail;
+	}
+	if (fchmod(fd, 0644) || !(out = fdopen(fd, "wb"))) {
+		close(fd);
+		goto fail;
+	}
+
+	memcpy(header, CORPUS_MAGIC, 4);
+	put_u32(header + 4, CORPUS_VERSION);
+	put_u64(header + 8, list.count);
+	status = fwrite(header, 1, sizeof(header), out) != sizeof(header);
+
+	off = CORPUS_HEADER_LEN + 8 * (uint64_t) list.count;
+	for (i = 0; i < list.count && !status; i++) {
+		put_u64(entry, off);
+		status = fwrite(entry, 1, sizeof(entry), out) != sizeof(entry);
+		off += list.sizes[i];
+	}
+
+	// The records of a file follow its header back to back, so once they
+	// check out they're copied in one go.
+	for (f = 0; f < n && !status; f++) {
+		*bad = inputs[f];
+		if (!(data = map_file(inputs[f], &len))) {
+			status = -1;
+			break;
+		}
+		if (walk_replay(data, len, check_record, &check)) {
+			errno = EINVAL;
+			status = -1;
+		}
+		else {
+			status = fwrite(data + REPLAY_HEADER_LEN, 1,
+					len - REPLAY_HEADER_LEN, out) !=
+					len - REPLAY_HEADER_LEN ? -1 : 0;
+		}
+		munmap((void *) data, len);
+	}
+
+	saved = errno;
+	if (fclose(out) && !status) {
+		*bad = path;
+		status = -1;
+	}
+	else {
+		errno = saved;
+	}
+	out = NULL;
+	if (status)
+		goto fail;
+	if (rename(tmp, path)) {
+		*bad = path;
+		goto fail;
+	}
+	free(tmp);
+	free(list.sizes);
+	return list.count;
+
+fail:
+	saved = errno;
+	if (out)
+		fclose(out);
+	if (tmp) {
+		unlink(tmp);
+		free(tmp);
+	}
+	free(list.sizes);
+	errno = saved;
+	return -1;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file
+ *
+ * Replay archives for re-scoring large numbers of recorded games, e.g.
+ * after every change to the physics. An archive is many replays packed into
+ * one file behind an index, which is mapped into memory and read in place,
+ * so scoring it takes neither a system call per replay nor any copying.
+ *
+ * All integers are little-endian:
+ *
+ *     header:   "FLPA" u32 version  u64 number of episodes
+ *     index:    u64 offset from the start of the file, per episode
+ *     records:  episode records, exactly as in a replay file (replay.h)
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "replay.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** A replay archive mapped into memory. */
+typedef struct corpus {
+	/* The whole file. */
+	const unsigned char *data;
+	size_t len;
+
+	/* Number of episodes, and where their offsets are. */
+	size_t count;
+	const unsigned char *index;
+} corpus;
+
+/** Outcome of replaying one episode of an archive. */
+typedef struct corpus_result {
+	/* What replay_play() said: 0 matched, 1 mismatched, -1 unreplayable. */
+	int status;
+
+	/* Frames played and score reached on replaying. */
+	int frames;
+	int score;
+} corpus_result;
+
+//---------------------------------- Functions --------------------------------
+
+int corpus_open(corpus *c, const char *path);
+void corpus_close(corpus *c);
+int corpus_episode(const corpus *c, size_t i, replay_episode *ep);
+int corpus_score(const corpus *c, int threads, corpus_result *results);
+int corpus_pack(const char *path, char *const *inputs, int n,
+		const char **bad);
+
+#endif
@@ -0,0 +1,277 @@
+/**
+ * @file
+ *
+ * Rasterizes a game into a cellbuf. See draw.h.
+ */
+
+#include <string.h>
+
+#include "draw.h"
+#include "text.h"
+
+//------------------------------ Global Constants -----------------------------
+
+const int MIN_ROWS = 16;
+
+const int MIN_COLS = 48;
+
+/** Most players the leaderboard shows. */
+static const int LEADERBOARD_LEN = 5;
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Works out where everything goes on a terminal of the given size. This is
+ * done once at startup and again whenever the terminal is resized, not on
+ * every frame.
+ *
+ * @param[out] l Layout to fill in.
+ * @param rows Terminal height.
+ * @param cols Terminal width.
+ */
+void layout_compute(layout *l, int rows, int cols) {
+	l->rows = rows;
+	l->cols = cols;
+	l->ceiling_row = 0;
+	l->floor_row = rows - 1;
+	// The score line is as wide as its format when both scores have one
+	// digit, less the two "%d".
+	l->score_col = cols - ((int) strlen(text(TEXT_SCORE)) - 2);
+
+	// Keep the length even so that the bar sits between its brackets.
+	l->prog_bar_len = (cols - 4) & ~1;
+	l->prog_bar_row = rows - 2;
+	l->prog_bar_col = cols / 2 - l->prog_bar_len / 2;
+
+	l->title_row = rows / 2 - 6;
+	l->title_col = cols / 2 - 22;
+	l->message_row = rows / 2 - 1;
+	l->message_col = cols / 2 - 22;
+	l->smooth = 0;
+}
+
+/**
+ * "Moving" floor and ceiling are written into the window array.
+ *
+ * @param cb Frame being drawn.
+ * @param l Layout of the screen.
+ * @param s Game whose score digits limit the ceiling.
+ * @param ch Char to use for the ceiling and floor.
+ * @param spacing Between chars in the floor and ceiling
+ * @param col_start Stagger the beginning of the floor and ceiling chars
+ * by this much
+ */
+void draw_floor_and_ceiling(cellbuf *cb, const layout *l, const game_state *s,
+		char ch, int spacing, int col_start) {
+	int score_col = l->score_col - s->sdigs - s->bdigs;
+	cellbuf_dotted(cb, l->ceiling_row, col_start,
+			score_col < l->cols - 1 ? score_col : l->cols - 1, spacing, ch);
+	cellbuf_dotted(cb, l->floor_row, col_start, l->cols - 1, spacing, ch);
+}
+
+/**
+ * Draws the given pipe on the window using 'vch' as the character for the
+ * vertical part of the pipe and 'hch' as the character for the horizontal
+ * part. The rows come from the spans cached in the pipe by pipe_shape(), so
+ * all that's left to do per frame is clip them horizontally.
+ *
+ * @param cb Frame being drawn.
+ * @param l Layout of the screen.
+ * @param p
+ * @param vch Character for vertical part of pipe
+ * @param hcht Character for horizontal part of top pipe
+ * @param hchb Character for horizontal part of lower pipe
+ */
+void draw_pipe(cellbuf *cb, const layout *l, vpipe p,
+		char vch, char hcht, char hchb) {
+	int left = p.center - PIPE_RADIUS, right = p.center + PIPE_RADIUS;
+	int width = 2 * PIPE_RADIUS + 1;
+	int upper_len = p.upper_lip - l->ceiling_row - 1;
+	int lower_len = l->floor_row - p.lower_lip - 1;
+	int last_col = l->cols - 1;
+
+	// Pipes never cover the last column.
+	if (right >= last_col)
+		width = last_col - left;
+
+	// Draw vertical part of upper half of pipe, then the horizontal part.
+	if (left >= 0 && left < last_col)
+		cellbuf_vline(cb, l->ceiling_row + 1, left, upper_len, vch);
+	if (right >= 0 && right < last_col)
+		cellbuf_vline(cb, l->ceiling_row + 1, right, upper_len, vch);
+	cellbuf_hline(cb, p.upper_lip, left, width, hcht);
+
+	// Same for the lower half.
+	if (left >= 0 && left < last_col)
+		cellbuf_vline(cb, p.lower_lip + 1, left, lower_len, vch);
+	if (right >= 0 && right < last_col)
+		cellbuf_vline(cb, p.lower_lip + 1, right, lower_len, vch);
+	cellbuf_hline(cb, p.lower_lip, left, width, hchb);
+}
+
+/**
+ * Draws Flappy.
+ *
+ * @param cb Frame being drawn.
+ * @param s The game Flappy the bird is in!
+ */
+void draw_flappy(cellbuf *cb, const game_state *s) {
+	flappy f = s->bird;
+	int h = get_flappy_position(f);
+
+	// If going down, don't flap
+	if (f.v > 0) {
+		cellbuf_put(cb, h, FLAPPY_COL - 1, '\\');
+		cellbuf_put(cb, h - 1, FLAPPY_COL - 2, '\\');
+		cellbuf_put(cb, h, FLAPPY_COL, '0');
+		cellbuf_put(cb, h, FLAPPY_COL + 1, '/');
+		cellbuf_put(cb, h - 1, FLAPPY_COL + 2, '/');
+	}
+
+	// If going up, flap!
+	else {
+		// Left wing
+		if (s->frame % 6 < 3) {
+			cellbuf_put(cb, h, FLAPPY_COL - 1, '/');
+			cellbuf_put(cb, h + 1, FLAPPY_COL - 2, '/');
+		}
+		else {
+			cellbuf_put(cb, h, FLAPPY_COL - 1, '\\');
+			cellbuf_put(cb, h - 1, FLAPPY_COL - 2, '\\');
+		}
+
+		// Body
+		cellbuf_put(cb, h, FLAPPY_COL, '0');
+
+		// Right wing
+		if (s->frame % 6 < 3) {
+			cellbuf_put(cb, h, FLAPPY_COL + 1, '\\');
+			cellbuf_put(cb, h + 1, FLAPPY_COL + 2, '\\');
+		}
+		else {
+			cellbuf_put(cb, h, FLAPPY_COL + 1, '/');
+			cellbuf_put(cb, h - 1, FLAPPY_COL + 2, '/');
+		}
+	}
+}
+
+/**
+ * Redraws Flappy's body with a half-block glyph, in the top or the bottom
+ * half of his row depending on where in the row he is. That shows his
+ * height at twice the resolution of the rows, so he glides rather than
+ * hopping from row to row, at no more frames per second. Call after
+ * draw_flappy().
+ */
+void draw_flappy_body(cellbuf *cb, const game_state *s) {
+	int lower = s->bird.y % ROW_SCALE >= ROW_SCALE / 2;
+
+	cellbuf_put(cb, get_flappy_position(s->bird), FLAPPY_COL,
+			lower ? GLYPH_LOWER_HALF : GLYPH_UPPER_HALF);
+}
+
+/**
+ * Draws a complete frame of the game: floor, ceiling, pipes, Flappy and the
+ * score line.
+ *
+ * @param cb Frame being drawn. Its previous contents are discarded.
+ * @param l Layout of the screen.
+ * @param s Game to draw.
+ */
+void draw_game(cellbuf *cb, const layout *l, const game_state *s) {
+	int i;
+
+	cellbuf_clear(cb);
+
+	// Print "moving" floor and ceiling
+	draw_floor_and_ceiling(cb, l, s, '/', 2, s->frame % 2);
+
+	// Draw the pipes on screen and Flappy.
+	for (i = 0; i < s->pipes.count; i++) {
+		vpipe p = POOL_PIPE(&s->pipes, i);
+		if (p.center - PIPE_RADIUS >= l->cols - 1)
+			break;
+		draw_pipe(cb, l, p, '|', '=', '=');
+	}
+	draw_flappy(cb, s);
+	if (l->smooth)
+		draw_flappy_body(cb, s);
+
+	cellbuf_printf(cb, l->ceiling_row, l->score_col - s->bdigs - s->sdigs,
+			text(TEXT_SCORE), s->score, s->best_score);
+}
+
+/**
+ * Draws a note at the left end of the status row, the ceiling row the score
+ * line is on. Call after draw_game().
+ */
+void draw_status(cellbuf *cb, const layout *l, const char *text) {
+	cellbuf_puts(cb, l->ceiling_row, 1, text);
+}
+
+/**
+ * Draws the screen asking the user to either play again or quit.
+ */
+void draw_failure(cellbuf *cb, const layout *l) {
+	cellbuf_clear(cb);
+	cellbuf_puts(cb, l->message_row, l->message_col, text(TEXT_DIED));
+}
+
+/**
+ * Draws the best players under the failure screen's message, as many as
+ * fit. Call after draw_failure().
+ *
+ * @param cb Frame being drawn.
+ * @param l Layout of the screen.
+ * @param top Records of the best players, best first.
+ * @param n Number of records.
+ */
+void draw_leaderboard(cellbuf *cb, const layout *l, const score_record *top,
+		int n) {
+	int row = l->message_row + 2, i;
+
+	if (n > LEADERBOARD_LEN)
+		n = LEADERBOARD_LEN;
+	for (i = 0; i < n && row + i < l->floor_row; i++)
+		cellbuf_printf(cb, row + i, l->message_col, "%2d. %-34.*s %6d", i + 1,
+				SCORE_NAME_LEN - 1, top[i].name, top[i].best);
+}
+
+/**
+ * Draws the splash screen with an empty progress bar. NB the ASCII art was
+ * generated by patorjk.com.
+ */
+void draw_splash(cellbuf *cb, const layout *l) {
+	int r = l->title_row;
+	int c = l->title_col;
+
+	cellbuf_clear(cb);
+
+	// Print the title.
+	cellbuf_puts(cb, r, c,     " ___ _                       ___ _        _ ");
+	cellbuf_puts(cb, r + 1, c, "| __| |__ _ _ __ _ __ _  _  | _ |_)_ _ __| |");
+	cellbuf_puts(cb, r + 2, c, "| _|| / _` | '_ \\ '_ \\ || | | _ \\ | '_/ _` |");
+	cellbuf_puts(cb, r + 3, c, "|_| |_\\__,_| .__/ .__/\\_, | |___/_|_| \\__,_|");
+	cellbuf_puts(cb, r + 4, c, "           |_|  |_|   |__/                  ");
+	cellbuf_puts(cb, l->rows / 2 + 1,
+			(l->cols - (int) strlen(text(TEXT_PROMPT))) / 2, text(TEXT_PROMPT));
+
+	// Print the progress bar.
+	cellbuf_puts(cb, l->prog_bar_row, l->prog_bar_col - 1, "[");
+	cellbuf_puts(cb, l->prog_bar_row, l->prog_bar_col + l->prog_bar_len, "]");
+}
+
+/**
+ * Fills in the first 'len' cells of the splash screen's progress bar.
+ */
+void draw_progress(cellbuf *cb, const layout *l, int len) {
+	cellbuf_hline(cb, l->prog_bar_row, l->prog_bar_col, len, '=');
+}
+
+/**
+ * Draws a note asking for a bigger terminal, as much of it as fits.
+ */
+void draw_too_small(cellbuf *cb, const layout *l) {
+	cellbuf_clear(cb);
+	cellbuf_printf(cb, l->rows / 2, 0, text(TEXT_TOO_SMALL), MIN_COLS,
+			MIN_ROWS);
+}
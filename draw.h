@@ -0,0 +1,70 @@
+/**
+ * @file
+ *
+ * Rasterizes a game into a cellbuf. Nothing in here talks to the terminal;
+ * see render.h for getting a cellbuf onto the screen.
+ */
+
+#ifndef DRAW_H
+#define DRAW_H
+
+#include "cellbuf.h"
+#include "scores.h"
+#include "sim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/**
+ * Where things go on the screen. Derived from the terminal size by
+ * layout_compute().
+ */
+typedef struct layout {
+	/* Terminal size. */
+	int rows, cols;
+
+	int ceiling_row, floor_row;
+
+	/* The score line starts here, minus the number of score digits. */
+	int score_col;
+
+	/* The splash screen's progress bar, not counting its brackets. */
+	int prog_bar_len, prog_bar_row, prog_bar_col;
+
+	/* Top left corner of the splash screen's title. */
+	int title_row, title_col;
+
+	/* Start of the failure screen's message. */
+	int message_row, message_col;
+
+	/*
+	 * Nonzero to draw Flappy to half a row with block glyphs. Set by the
+	 * caller after layout_compute(), which turns it off.
+	 */
+	int smooth;
+} layout;
+
+//------------------------------ Global Constants -----------------------------
+
+/** Smallest terminal the game can be laid out in. */
+extern const int MIN_ROWS;
+extern const int MIN_COLS;
+
+//---------------------------------- Functions --------------------------------
+
+void layout_compute(layout *l, int rows, int cols);
+void draw_floor_and_ceiling(cellbuf *cb, const layout *l, const game_state *s,
+		char ch, int spacing, int col_start);
+void draw_pipe(cellbuf *cb, const layout *l, vpipe p,
+		char vch, char hcht, char hchb);
+void draw_flappy(cellbuf *cb, const game_state *s);
+void draw_flappy_body(cellbuf *cb, const game_state *s);
+void draw_game(cellbuf *cb, const layout *l, const game_state *s);
+void draw_status(cellbuf *cb, const layout *l, const char *text);
+void draw_failure(cellbuf *cb, const layout *l);
+void draw_leaderboard(cellbuf *cb, const layout *l, const score_record *top,
+		int n);
+void draw_splash(cellbuf *cb, const layout *l);
+void draw_progress(cellbuf *cb, const layout *l, int len);
+void draw_too_small(cellbuf *cb, const layout *l);
+
+#endif
@@ -2,492 +2,604 @@
  * @file
  * @author Hamik Mukelyan
  *
- * Drives a text-based Flappy Bird knock-off that is intended to run in an
- * 80 x 24 console.
+ * Drives a text-based Flappy Bird knock-off. The board fills the console,
+ * which should be at least 48 x 16; the classic size is 80 x 24.
  */
 
-#include <ncurses.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <assert.h>
 #include <limits.h>
+#include <getopt.h>
+#include <errno.h>
+#include <string.h>
+
+#include "autopilot.h"
+#include "backend.h"
+#include "cast.h"
+#include "headless.h"
+#include "profile.h"
+#include "replay.h"
+#include "scores.h"
+#include "server.h"
+#include "session.h"
+#include "sim.h"
+#include "stats.h"
+#include "text.h"
+#include "ticker.h"
+
+//------------------------------ Global Constants -----------------------------
+
+/** Frames --autoplay looks ahead. */
+const int AUTOPLAY_HORIZON = 40;
+
+/** Most players --serve takes at once by default. */
+const int DEFAULT_MAX_CLIENTS = 256;
 
 //-------------------------------- Definitions --------------------------------
 
-/**
- * Represents a vertical pipe through which Flappy The Bird is supposed to fly.
- */
-typedef struct vpipe {
-
-	/*
-	 * The height of the opening of the pipe as a fraction of the height of the
-	 * console window.
-	 */
-	float opening_height;
-
-	/*
-	 * Center of the pipe is at this column number (e.g. somewhere in [0, 79]).
-	 * When the center + radius is negative then the pipe's center is rolled
-	 * over to somewhere > the number of columns and the opening height is
-	 * changed.
-	 */
-	int center;
-} vpipe;
-
-/** Represents Flappy the Bird. */
-typedef struct flappy {
-	/* Height of Flappy the Bird at the last up arrow press. */
-	int h0;
-
-	/* Time since last up arrow pressed. */
-	int t;
-} flappy;
+/** Command line settings. */
+typedef struct options {
+	/* Number of headless episodes to play, or 0 to play interactively. */
+	int batch;
 
-//------------------------------ Global Constants -----------------------------
+	/* Worker threads for --batch. */
+	int threads;
 
-/** Gravitational acceleration constant */
-const float GRAV = 0.05;
+	/* Frame limit per --batch episode; 0 for no limit. */
+	int max_frames;
 
-/** Initial velocity with up arrow press */
-const float V0 = -0.5;
+	/* Columns the pipes move per frame in --batch episodes. */
+	int scroll;
 
-/** Number of rows in the console window. */
-const int NUM_ROWS = 24;
+	/* Seed for the pipe openings. */
+	unsigned int seed;
 
-/** Number of columns in the console window. */
-const int NUM_COLS = 80;
+	/* Replay file to append the session to, or NULL. */
+	const char *record;
 
-/** Radius of each vertical pipe. */
-const int PIPE_RADIUS = 3;
+	/* Replay file to play back and verify, or NULL. */
+	const char *replay;
 
-/** Width of the opening in each pipe. */
-const int OPENING_WIDTH = 7;
+	/* Archive to pack the replay files 'inputs' into, or NULL. */
+	const char *pack;
+	char **inputs;
+	int ninputs;
 
-/** Flappy stays in this column. */
-const int FLAPPY_COL = 10;
+	/* Archive to re-score with 'threads' threads, or NULL. */
+	const char *score;
 
-/** Aiming for this many frames per second. */
-const float TARGET_FPS = 24;
+	/* Nonzero to time every frame, and the file to log the times to. */
+	int stats;
+	const char *stats_csv;
 
-/** Amount of time the splash screen stays up. */
-const float START_TIME_SEC = 3;
+	/* TCP port to serve games on, or 0, and how many players at most. */
+	int serve;
+	int max_clients;
 
-/** Length of the "progress bar" on the status screen. */
-const int PROG_BAR_LEN = 76;
+	/* Nonzero to drive the terminal with raw ANSI output, not ncurses. */
+	int ansi;
 
-/** Row number at which the progress bar will show. */
-const int PROG_BAR_ROW = 22;
+	/* Nonzero to let the autopilot play. */
+	int autoplay;
 
-const int SCORE_START_COL = 62;
+	/* File to record the terminal to as an asciicast, or NULL. */
+	const char *cast;
+
+	/* High-score file, or NULL. */
+	const char *scores;
+
+	/* Difficulty profile file, or NULL. */
+	const char *profile;
+
+	/* Nonzero to draw Flappy to half a row with block glyphs. */
+	int smooth;
+
+	/* Language to talk to players in, or NULL to follow the locale. */
+	const char *lang;
+} options;
 
 //------------------------------ Global Variables -----------------------------
 
-/** Frame number. */
-int frame = 0;
+/** Drives the terminal; --ansi picks the raw ANSI one. */
+const term_backend *backend = &term_curses;
 
-/** Number of pipes that have been passed. */
-int score = 0;
+/** Records the session with --record; NULL otherwise. */
+replay_writer *recorder = NULL;
 
-/** Number of digits in the score. */
-int sdigs = 1;
+/** Times frames with --stats; NULL otherwise. */
+frame_stats *stats = NULL;
 
-/** Best score so far. */
-int best_score = 0;
+/** Plays the game with --autoplay; NULL otherwise. */
+autopilot *pilot = NULL;
 
-/** Number of digits in the best score. */
-int bdigs = 1;
+/** Records the terminal with --cast; NULL otherwise. */
+cast_recorder *caster = NULL;
 
-/** The vertical pipe obstacles. */
-vpipe p1, p2;
+/** Keeps the high scores with --scores; NULL otherwise. */
+score_store *scores = NULL;
+
+/** Name the player's scores go under. */
+const char *player = "anonymous";
+
+/** Difficulty profile from --profile; NULL for the classic game. */
+const profile *difficulty = NULL;
 
 //---------------------------------- Functions --------------------------------
 
 /**
- * Converts the given char into a string.
+ * Restores the terminal and finishes the recordings, the frame times and
+ * the high scores.
  *
- * @param ch Char to convert to a string.
- * @param[out] str Receives 'ch' into a null-terminated C string. Assumes
- * str had 2 bytes allocated.
+ * @return Exit status for the program.
  */
-void chtostr(char ch, char *str) {
-	str[0] = ch;
-	str[1] = '\0';
+int finish(void) {
+	int status = 0;
+
+	backend->close();
+	if (recorder && replay_close(recorder)) {
+		perror("flap: writing the replay");
+		status = 1;
+	}
+	if (stats && stats_close(stats)) {
+		perror("flap: writing the frame times");
+		status = 1;
+	}
+	if (caster) {
+		if (caster->dropped > 0)
+			fprintf(stderr, "flap: the recording fell behind; %ld frames "
+					"were dropped\n", caster->dropped);
+		if (cast_close(caster)) {
+			perror("flap: writing the asciicast");
+			status = 1;
+		}
+	}
+	if (scores) {
+		if (scores_flush(scores)) {
+			perror("flap: writing the high scores");
+			status = 1;
+		}
+		scores_close(scores);
+	}
+	return status;
 }
 
 /**
- * "Moving" floor and ceiling are written into the window array.
- *
- * @param ceiling_row
- * @param floor_row
- * @param ch Char to use for the ceiling and floor.
- * @param spacing Between chars in the floor and ceiling
- * @param col_start Stagger the beginning of the floor and ceiling chars
- * by this much
+ * Lays the screen out for the current terminal size and resizes the frame
+ * buffers to match. Called only when the backend reports TERM_KEY_RESIZE,
+ * so nothing is re-derived per frame.
  */
-void draw_floor_and_ceiling(int ceiling_row, int floor_row,
-		char ch, int spacing, int col_start) {
-	char c[2];
-	chtostr(ch, c);
-	int i;
-	for (i = col_start; i < NUM_COLS - 1; i += spacing) {
-		if (i < SCORE_START_COL - sdigs - bdigs)
-			mvprintw(ceiling_row, i, c);
-		mvprintw(floor_row, i, c);
+void screen_fit(session *ss) {
+	int rows, cols;
+
+	backend->size(&rows, &cols);
+	if (session_resize(ss, rows, cols) || backend->resize(rows, cols)) {
+		backend->close();
+		fprintf(stderr, "flap: out of memory\n");
+		exit(1);
 	}
 }
 
 /**
- * Updates the pipe center and opening height for each new frame. If the pipe
- * is sufficiently far off-screen to the left the center is wrapped around to
- * the right, at which time the opening height is changed.
+ * Shows the session's frame on the terminal, and records it with --cast.
  */
-void pipe_refresh(vpipe *p) {
-
-	// If pipe exits screen on the left then wrap it to the right side of the
-	// screen.
-	if(p->center + PIPE_RADIUS < 0) {
-		p->center = NUM_COLS + PIPE_RADIUS;
-
-		// Get an opening height fraction.
-		p->opening_height = rand() / ((float) INT_MAX) * 0.5 + 0.25;
-		score++;
-		if(sdigs == 1 && score > 9)
-			sdigs++;
-		else if(sdigs == 2 && score > 99)
-			sdigs++;
-	}
-	p->center--;
+static void show(session *ss) {
+	backend->flush(&ss->frame);
+	if (caster)
+		cast_frame(caster, &ss->frame);
 }
 
 /**
- * Gets the row number of the top or bottom of the opening in the given pipe.
- *
- * @param p The pipe obstacle.
- * @param top Should be 1 for the top, 0 for the bottom.
- *
- * @return Row number.
+ * Saves the score of the game that just ended to the high-score file, and
+ * picks up the player's best from other games meanwhile. If the file can't
+ * be written the score stays queued for the next game over. Games the
+ * autopilot plays don't count.
  */
-int get_orow(vpipe p, int top) {
-	return p.opening_height * (NUM_ROWS - 1) -
-			(top ? 1 : -1) * OPENING_WIDTH / 2;
+static void save_score(session *ss) {
+	game_state *s = &ss->s;
+	int best;
+
+	if (!scores || pilot)
+		return;
+	if (!scores_submit(scores, player, s->score))
+		scores_flush(scores);
+	best = scores_best(scores, player);
+	if (best > s->best_score)
+		sim_set_best(s, best);
 }
 
+/** How the session on the terminal gets its frames out and its scores in. */
+static const session_hooks terminal_hooks = { show, save_score };
+
 /**
- * Draws the given pipe on the window using 'vch' as the character for the
- * vertical part of the pipe and 'hch' as the character for the horizontal
- * part.
+ * Sets up the session on the terminal, starting on the splash screen.
  *
- * @param p
- * @param vch Character for vertical part of pipe
- * @param hcht Character for horizontal part of top pipe
- * @param hchb Character for horizontal part of lower pipe
- * @param ceiling_row Start the pipe just below this
- * @param floor_row Star the pipe jut above this
+ * @param[out] ss Session to start.
+ * @param seed Seed of the first game.
+ * @param smooth Nonzero with --smooth; see layout.smooth.
  */
-void draw_pipe(vpipe p, char vch, char hcht, char hchb,
-		int ceiling_row, int floor_row) {
-	int i, upper_terminus, lower_terminus;
-	char c[2];
-
-	// Draw vertical part of upper half of pipe.
-	for(i = ceiling_row + 1; i < get_orow(p, 1); i++) {
-		if ((p.center - PIPE_RADIUS) >= 0 &&
-				(p.center - PIPE_RADIUS) < NUM_COLS - 1) {
-			chtostr(vch, c);
-			mvprintw(i, p.center - PIPE_RADIUS, c);
-		}
-		if ((p.center + PIPE_RADIUS) >= 0 &&
-				(p.center + PIPE_RADIUS) < NUM_COLS - 1) {
-			chtostr(vch, c);
-			mvprintw(i, p.center + PIPE_RADIUS, c);
-		}
-	}
-	upper_terminus = i;
-
-	// Draw horizontal part of upper part of pipe.
-	for (i = -PIPE_RADIUS; i <= PIPE_RADIUS; i++) {
-		if ((p.center + i) >= 0 &&
-				(p.center + i) < NUM_COLS - 1) {
-			chtostr(hcht, c);
-			mvprintw(upper_terminus, p.center + i, c);
-		}
-	}
-
-	// Draw vertical part of lower half of pipe.
-	for(i = floor_row - 1; i > get_orow(p, 0); i--) {
-		if ((p.center - PIPE_RADIUS) >= 0 &&
-				(p.center - PIPE_RADIUS) < NUM_COLS - 1) {
-			chtostr(vch, c);
-			mvprintw(i, p.center - PIPE_RADIUS, c);
-		}
-		if ((p.center + PIPE_RADIUS) >= 0 &&
-				(p.center + PIPE_RADIUS) < NUM_COLS - 1) {
-			chtostr(vch, c);
-			mvprintw(i, p.center + PIPE_RADIUS, c);
-		}
-	}
-	lower_terminus = i;
-
-	// Draw horizontal part of lower part of pipe.
-	for (i = -PIPE_RADIUS; i <= PIPE_RADIUS; i++) {
-		if ((p.center + i) >= 0 &&
-				(p.center + i) < NUM_COLS - 1) {
-			chtostr(hchb, c);
-			mvprintw(lower_terminus, p.center + i, c);
-		}
+void terminal_start(session *ss, unsigned int seed, int smooth) {
+	int rows, cols;
+
+	ss->hooks = &terminal_hooks;
+	ss->profile = difficulty;
+	ss->smooth = smooth;
+	ss->recorder = recorder;
+	ss->stats = stats;
+	ss->pilot = pilot;
+	ss->scores = scores;
+
+	backend->size(&rows, &cols);
+	if (session_start(ss, rows, cols, seed) || backend->resize(rows, cols)) {
+		backend->close();
+		fprintf(stderr, "flap: out of memory\n");
+		exit(1);
 	}
+	if (scores)
+		sim_set_best(&ss->s, scores_best(scores, player));
 }
 
 /**
- * Get Flappy's height along its parabolic arc.
- *
- * @param f Flappy!
- *
- * @return height as a row count
+ * Prints the command line usage.
  */
-int get_flappy_position(flappy f) {
-	return f.h0 + V0 * f.t + 0.5 * GRAV * f.t * f.t;
+void usage(FILE *out) {
+	fprintf(out,
+			"Usage: flap [options]\n"
+			"       flap --pack ARCHIVE REPLAY...\n");
+	headless_usage(out);
+	fprintf(out,
+			"  --record FILE   append every game played to a replay file\n"
+			"  --stats         show how long frames take in the status row\n"
+			"  --stats-csv FILE\n"
+			"                  also log the time of every phase of every\n"
+			"                  frame to a CSV file\n"
+			"  --serve PORT    host games for players connecting with telnet\n"
+			"  --max-clients N most players --serve takes at once (default %d)\n"
+			"  --ansi          draw with raw ANSI escape sequences instead of\n"
+			"                  ncurses\n"
+			"  --autoplay      let an autopilot play, game after game, until\n"
+			"                  'q' is pressed\n"
+			"  --cast FILE     record the terminal to an asciicast file for\n"
+			"                  asciinema\n"
+			"  --scores FILE   keep everyone's best scores in FILE, which any\n"
+			"                  number of games and servers can share\n"
+			"  --smooth        draw Flappy to half a row with Unicode block\n"
+			"                  glyphs (implies --ansi; needs a UTF-8 terminal)\n"
+			"  --lang LANG     talk to players in LANG, en or pt-br (default:\n"
+			"                  the locale's language, or else en)\n"
+			"  --help          show this message\n", DEFAULT_MAX_CLIENTS);
 }
 
 /**
- * Returns true if Flappy crashed into a pipe.
- *
- * @param f Flappy!
- * @param p The vertical pipe obstacle.
- *
- * @return 1 if Flappy crashed, 0 otherwise.
+ * Parses a non-negative integer command line argument, or exits with a
+ * usage message if it isn't one.
  */
-int crashed_into_pipe(flappy f, vpipe p) {
-	if (FLAPPY_COL >= p.center - PIPE_RADIUS - 1 &&
-			FLAPPY_COL <= p.center + PIPE_RADIUS + 1) {
-
-		if (get_flappy_position(f) >= get_orow(p, 1)  + 1 &&
-				get_flappy_position(f) <= get_orow(p, 0) - 1) {
-			return 0;
-		}
-		else {
-			return 1;
-		}
+int parse_count(const char *name, const char *arg) {
+	int n;
+	if (headless_count(arg, &n)) {
+		fprintf(stderr, "flap: %s needs a non-negative number, not '%s'\n",
+				name, arg);
+		usage(stderr);
+		exit(2);
 	}
-	return 0;
+	return n;
 }
 
 /**
- * Prints a failure screen asking the user to either play again or quit.
- *
- * @return 1 if the user wants to play again. Exits the program otherwise.
+ * Parses a seed command line argument, or exits with a usage message if it
+ * isn't a valid one.
  */
-int failure_screen() {
-	char ch;
-	clear();
-	mvprintw(NUM_ROWS / 2 - 1, NUM_COLS / 2 - 22,
-			"Flappy died :-(. <Enter> to flap, 'q' to quit.\n");
-	refresh();
-	timeout(-1); // Block until user enters something.
-	ch = getch();
-	switch(ch) {
-	case 'q': // Quit.
-		endwin();
-		exit(0);
-		break;
-	default:
-		if (score > best_score)
-			best_score = score;
-		if (bdigs == 1 && best_score > 9)
-			bdigs++;
-		else if(bdigs == 2 && best_score > 99)
-			bdigs++;
-		score = 0;
-		sdigs = 1;
-		return 1; // Restart game.
+unsigned int parse_seed(const char *arg) {
+	unsigned int n;
+	if (headless_seed(arg, &n)) {
+		fprintf(stderr, "flap: --seed needs a number up to %u, not '%s'\n",
+				UINT_MAX, arg);
+		usage(stderr);
+		exit(2);
 	}
-	endwin();
-	exit(0);
+	return n;
 }
 
 /**
- * Draws Flappy to the screen and shows death message if Flappy collides with
- * ceiling or floor. The user can continue to play or can exit if Flappy
- * dies.
- *
- * @param f Flappy the bird!
- *
- * @return 0 if Flappy was drawn as expected, 1 if the game should restart.
+ * Fills in the settings from the command line, or exits with a usage
+ * message if it doesn't make sense.
  */
-int draw_flappy(flappy f) {
-	char c[2];
-	int h = get_flappy_position(f);
-
-	// If Flappy crashed into the ceiling or the floor...
-	if (h <= 0 || h >= NUM_ROWS - 1)
-		return failure_screen();
-
-	// If Flappy crashed into a pipe...
-	if (crashed_into_pipe(f, p1) || crashed_into_pipe(f, p2)) {
-		return failure_screen();
-	}
-
-	// If going down, don't flap
-	if (GRAV * f.t + V0 > 0) {
-		chtostr('\\', c);
-		mvprintw(h, FLAPPY_COL - 1, c);
-		mvprintw(h - 1, FLAPPY_COL - 2, c);
-		chtostr('0', c);
-		mvprintw(h, FLAPPY_COL, c);
-		chtostr('/', c);
-		mvprintw(h, FLAPPY_COL + 1, c);
-		mvprintw(h - 1, FLAPPY_COL + 2, c);
-	}
-
-	// If going up, flap!
-	else {
-		// Left wing
-		if (frame % 6 < 3) {
-			chtostr('/', c);
-			mvprintw(h, FLAPPY_COL - 1, c);
-			mvprintw(h + 1, FLAPPY_COL - 2, c);
-		}
-		else {
-			chtostr('\\', c);
-			mvprintw(h, FLAPPY_COL - 1, c);
-			mvprintw(h - 1, FLAPPY_COL - 2, c);
+void parse_options(int argc, char **argv, options *opt) {
+	static const struct option longopts[] = {
+		{ "batch",      required_argument, NULL, 'b' },
+		{ "threads",    required_argument, NULL, 't' },
+		{ "max-frames", required_argument, NULL, 'm' },
+		{ "scroll",     required_argument, NULL, 'x' },
+		{ "seed",       required_argument, NULL, 's' },
+		{ "record",     required_argument, NULL, 'r' },
+		{ "replay",     required_argument, NULL, 'p' },
+		{ "pack",       required_argument, NULL, 'a' },
+		{ "score",      required_argument, NULL, 'c' },
+		{ "stats",      no_argument,       NULL, 'S' },
+		{ "stats-csv",  required_argument, NULL, 'C' },
+		{ "serve",      required_argument, NULL, 'v' },
+		{ "max-clients", required_argument, NULL, 'n' },
+		{ "ansi",       no_argument,       NULL, 'A' },
+		{ "autoplay",   no_argument,       NULL, 'P' },
+		{ "cast",       required_argument, NULL, 'k' },
+		{ "scores",     required_argument, NULL, 'o' },
+		{ "profile",    required_argument, NULL, 'f' },
+		{ "smooth",     no_argument,       NULL, 'u' },
+		{ "lang",       required_argument, NULL, 'l' },
+		{ "help",       no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+	int c;
+
+	opt->batch = 0;
+	opt->threads = 1;
+	opt->max_frames = HEADLESS_MAX_FRAMES;
+	opt->scroll = 1;
+	opt->seed = time(NULL);
+	opt->record = NULL;
+	opt->replay = NULL;
+	opt->pack = NULL;
+	opt->score = NULL;
+	opt->stats = 0;
+	opt->stats_csv = NULL;
+	opt->serve = 0;
+	opt->max_clients = DEFAULT_MAX_CLIENTS;
+	opt->ansi = 0;
+	opt->autoplay = 0;
+	opt->cast = NULL;
+	opt->scores = NULL;
+	opt->profile = NULL;
+	opt->smooth = 0;
+	opt->lang = NULL;
+
+	while ((c = getopt_long(argc, argv, "", longopts, NULL)) != -1) {
+		switch (c) {
+		case 'b':
+			opt->batch = parse_count("--batch", optarg);
+			break;
+		case 't':
+			opt->threads = parse_count("--threads", optarg);
+			break;
+		case 'm':
+			opt->max_frames = parse_count("--max-frames", optarg);
+			break;
+		case 'x':
+			opt->scroll = parse_count("--scroll", optarg);
+			break;
+		case 's':
+			opt->seed = parse_seed(optarg);
+			break;
+		case 'r':
+			opt->record = optarg;
+			break;
+		case 'p':
+			opt->replay = optarg;
+			break;
+		case 'a':
+			opt->pack = optarg;
+			break;
+		case 'c':
+			opt->score = optarg;
+			break;
+		case 'S':
+			opt->stats = 1;
+			break;
+		case 'C':
+			opt->stats = 1;
+			opt->stats_csv = optarg;
+			break;
+		case 'v':
+			opt->serve = parse_count("--serve", optarg);
+			break;
+		case 'n':
+			opt->max_clients = parse_count("--max-clients", optarg);
+			break;
+		case 'A':
+			opt->ansi = 1;
+			break;
+		case 'P':
+			opt->autoplay = 1;
+			break;
+		case 'k':
+			opt->cast = optarg;
+			break;
+		case 'o':
+			opt->scores = optarg;
+			break;
+		case 'f':
+			opt->profile = optarg;
+			break;
+		case 'u':
+			opt->smooth = 1;
+			opt->ansi = 1;
+			break;
+		case 'l':
+			opt->lang = optarg;
+			break;
+		case 'h':
+			usage(stdout);
+			exit(0);
+		default:
+			usage(stderr);
+			exit(2);
 		}
+	}
 
-		// Body
-		chtostr('0', c);
-		mvprintw(h, FLAPPY_COL, c);
-
-		// Right wing
-		if (frame % 6 < 3) {
-			chtostr('\\', c);
-			mvprintw(h, FLAPPY_COL + 1, c);
-			mvprintw(h + 1, FLAPPY_COL + 2, c);
-		}
-		else {
-			chtostr('/', c);
-			mvprintw(h, FLAPPY_COL + 1, c);
-			mvprintw(h - 1, FLAPPY_COL + 2, c);
-		}
+	// Only --pack takes more arguments: the replay files to pack.
+	opt->inputs = argv + optind;
+	opt->ninputs = argc - optind;
+	if ((opt->pack ? opt->ninputs == 0 : opt->ninputs > 0) ||
+			opt->threads < 1 || opt->scroll < 1 || opt->serve > 65535 ||
+			opt->max_clients < 1) {
+		usage(stderr);
+		exit(2);
 	}
+}
 
-	return 0;
+/**
+ * Picks out the settings for the headless modes.
+ */
+void headless_settings(const options *opt, headless_options *hl) {
+	hl->batch = opt->batch;
+	hl->threads = opt->threads;
+	hl->max_frames = opt->max_frames;
+	hl->scroll = opt->scroll;
+	hl->seed = opt->seed;
+	hl->profile = difficulty;
+	hl->replay = opt->replay;
+	hl->pack = opt->pack;
+	hl->inputs = opt->inputs;
+	hl->ninputs = opt->ninputs;
+	hl->score = opt->score;
 }
 
 /**
- * Print a splash screen and show a progress bar. NB the ASCII art was
- * generated by patorjk.com.
+ * Hosts games for players connecting over the network until interrupted.
+ *
+ * @return Exit status for the program.
  */
-void splash_screen() {
-	int i;
-	int r = NUM_ROWS / 2 - 6;
-	int c = NUM_COLS / 2 - 22;
-
-	// Print the title.
-	mvprintw(r, c,     " ___ _                       ___ _        _ ");
-	mvprintw(r + 1, c, "| __| |__ _ _ __ _ __ _  _  | _ |_)_ _ __| |");
-	mvprintw(r + 2, c, "| _|| / _` | '_ \\ '_ \\ || | | _ \\ | '_/ _` |");
-	mvprintw(r + 3, c, "|_| |_\\__,_| .__/ .__/\\_, | |___/_|_| \\__,_|");
-	mvprintw(r + 4, c, "           |_|  |_|   |__/                  ");
-	mvprintw(NUM_ROWS / 2 + 1, NUM_COLS / 2 - 10,
-			"Press <up> to flap!");
-
-	// Print the progress bar.
-	mvprintw(PROG_BAR_ROW, NUM_COLS / 2 - PROG_BAR_LEN / 2 - 1, "[");
-	mvprintw(PROG_BAR_ROW, NUM_COLS / 2 + PROG_BAR_LEN / 2, "]");
-	refresh();
-	for(i = 0; i < PROG_BAR_LEN; i++) {
-		usleep(1000000 * START_TIME_SEC / (float) PROG_BAR_LEN);
-		mvprintw(PROG_BAR_ROW, NUM_COLS / 2 - PROG_BAR_LEN / 2 + i, "=");
-		refresh();
+int run_serve(const options *opt) {
+	server_config cfg;
+	int status = 0;
+
+	cfg.port = opt->serve;
+	cfg.max_clients = opt->max_clients;
+	cfg.seed = opt->seed;
+	cfg.scores = scores;
+	cfg.profile = difficulty;
+	cfg.smooth = opt->smooth;
+	if (server_run(&cfg)) {
+		fprintf(stderr, "flap: --serve %d: %s\n", opt->serve, strerror(errno));
+		status = 1;
 	}
-	usleep(1000000 * 0.5);
+	if (scores) {
+		if (scores_flush(scores)) {
+			perror("flap: writing the high scores");
+			status = 1;
+		}
+		scores_close(scores);
+	}
+	return status;
 }
 
 //------------------------------------ Main -----------------------------------
 
-int main()
+int main(int argc, char **argv)
 {
-	int leave_loop = 0;
-	int ch;
-	flappy f;
-	int restart = 1;
-
-	srand(time(NULL));
-
-	// Initialize ncurses
-	initscr();
-	raw();					// Disable line buffering
-	keypad(stdscr, TRUE);
-	noecho();				// Don't echo() for getch
-	curs_set(0);
-	timeout(0);
-
-	splash_screen();
-
-	while(!leave_loop) {
-
-		// If we're just starting a game then do some initializations.
-		if (restart) {
-			timeout(0); // Don't block on input.
-
-			// Start the pipes just out of view on the right.
-			p1.center = (int)(1.2 * (NUM_COLS - 1));
-			p1.opening_height = rand() / ((float) INT_MAX) * 0.5 + 0.25;
-			p2.center = (int)(1.75 * (NUM_COLS - 1));
-			p2.opening_height = rand() / ((float) INT_MAX) * 0.5 + 0.25;
-
-			// Initialize flappy
-			f.h0 = NUM_ROWS / 2;
-			f.t = 0;
-			restart = 0;
-		}
-
-		usleep((unsigned int) (1000000 / TARGET_FPS));
+	ticker tk;
+	term_input in;
+	options opt;
+	int ticks;
+	static session ss;
+	static replay_writer rw;
+	static frame_stats fs;
+	static autopilot ap;
+	static cast_recorder cr;
+	static score_store st;
+	static profile prof;
+	headless_options hl;
+	int rows, cols;
+
+	parse_options(argc, argv, &opt);
+	if (text_set_language(opt.lang)) {
+		fprintf(stderr, "flap: --lang %s: not a language flap speaks\n",
+				opt.lang);
+		usage(stderr);
+		return 2;
+	}
+	if (opt.profile) {
+		if (headless_load_profile(&prof, opt.profile))
+			return 1;
+		difficulty = &prof;
+	}
+	headless_settings(&opt, &hl);
+	if (headless_wanted(&hl))
+		return headless_run(&hl);
 
-		// Process keystrokes.
-		ch = -1;
-		ch = getch();
-		switch (ch) {
-		case 'q': // Quit.
-			endwin();
-			exit(0);
-			break;
-		case KEY_UP: // Give Flappy a boost!
-			f.h0 = get_flappy_position(f);
-			f.t = 0;
-			break;
-		default: // Let Flappy fall along his parabola.
-			f.t++;
+	if (opt.scores) {
+		if (scores_open(&st, opt.scores)) {
+			fprintf(stderr, "flap: %s: %s\n", opt.scores, strerror(errno));
+			return 1;
 		}
+		scores = &st;
+		if (getenv("USER") && *getenv("USER"))
+			player = getenv("USER");
+	}
+	if (opt.serve)
+		return run_serve(&opt);
 
-		clear();
-
-		// Print "moving" floor and ceiling
-		draw_floor_and_ceiling(0, NUM_ROWS - 1, '/', 2, frame % 2);
-
-		// Update pipe locations and draw them.
-		draw_pipe(p1, '|', '=', '=', 0, NUM_ROWS - 1);
-		draw_pipe(p2, '|', '=', '=', 0, NUM_ROWS - 1);
-		pipe_refresh(&p1);
-		pipe_refresh(&p2);
-
-		// Draw Flappy. If Flappy crashed and user wants a restart...
-		if(draw_flappy(f)) {
-			restart = 1;
-			continue; // ...then restart the game.
+	if (opt.record) {
+		if (replay_open(&rw, opt.record)) {
+			fprintf(stderr, "flap: %s: %s\n", opt.record, strerror(errno));
+			return 1;
+		}
+		recorder = &rw;
+	}
+	if (opt.stats) {
+		if (stats_init(&fs, opt.stats_csv)) {
+			fprintf(stderr, "flap: %s: %s\n", opt.stats_csv, strerror(errno));
+			return 1;
 		}
+		stats = &fs;
+	}
 
-		mvprintw(0, SCORE_START_COL - bdigs - sdigs,
-				" Score: %d  Best: %d", score, best_score);
+	if (opt.autoplay) {
+		if (autopilot_init(&ap, AUTOPLAY_HORIZON)) {
+			fprintf(stderr, "flap: out of memory\n");
+			return 1;
+		}
+		pilot = &ap;
+	}
 
-		// Display all the chars for this frame.
-		refresh();
-		frame++;
+	if (opt.ansi)
+		backend = &term_ansi;
+	if (backend->open()) {
+		perror("flap: --ansi");
+		return 1;
+	}
+	if (opt.cast) {
+		backend->size(&rows, &cols);
+		if (cast_open(&cr, opt.cast, rows, cols)) {
+			int err = errno;
+			finish();
+			fprintf(stderr, "flap: %s: %s\n", opt.cast, strerror(err));
+			return 1;
+		}
+		caster = &cr;
 	}
 
-	endwin();
+	terminal_start(&ss, opt.seed, opt.smooth);
+	ticker_start(&tk, SESSION_FPS);
+	if (ticker_open_timer(&tk)) {
+		finish();
+		perror("flap: timerfd");
+		return 1;
+	}
+	memset(&in, 0, sizeof(in));
+
+	// Block until the next tick is due or a key is pressed. If we fell
+	// behind, several ticks are due at once; all of them are simulated but
+	// only the last one is drawn. Keys are read as soon as they arrive but
+	// a flap waits for the next tick, as the game moves in whole ticks;
+	// everything else is handled right away. While the session is idle no
+	// ticks are scheduled at all.
+	while (ss.mode != MODE_QUIT) {
+		ticks = ticker_poll(&tk, backend->fd, ss.idle);
+		term_drain(backend, &in);
+		if (ticks == 0 && (in.keys == 0 ||
+				(ss.mode == MODE_PLAYING && !ss.idle && !in.quit)))
+			continue;
+		if (in.resized) // Lay everything out again.
+			screen_fit(&ss);
+		session_tick(&ss, &in, ticks);
+		memset(&in, 0, sizeof(in));
+	}
 
-	return 0;
+	ticker_close(&tk);
+	session_free(&ss);
+	if (pilot)
+		autopilot_free(pilot);
+	return finish();
 }
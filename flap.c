@@ -0,0 +1,140 @@
+/**
+ * @file
+ *
+ * Reinforcement-learning environment on top of the headless engine. See
+ * flap.h.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "cellbuf.h"
+#include "draw.h"
+#include "flap.h"
+#include "sim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+struct flap_env {
+	game_state s;
+
+	/* Where the grid observation's parts go. */
+	layout l;
+};
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Creates an environment with a board of the given size; NUM_ROWS x
+ * NUM_COLS is the classic one. Call flap_reset() before the first step.
+ *
+ * @return The environment, or NULL with errno set if the board is smaller
+ * than MIN_ROWS x MIN_COLS or memory ran out.
+ */
+flap_env *flap_new(int rows, int cols) {
+	flap_env *env;
+
+	if (rows < MIN_ROWS || cols < MIN_COLS) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (!(env = malloc(sizeof(*env))))
+		return NULL;
+	sim_init(&env->s, rows, cols, 0);
+	layout_compute(&env->l, rows, cols);
+	return env;
+}
+
+void flap_free(flap_env *env) {
+	free(env);
+}
+
+/**
+ * Starts a new episode. The same seed and actions give the same episode.
+ */
+void flap_reset(flap_env *env, unsigned int seed) {
+	sim_init(&env->s, env->s.rows, env->s.cols, seed);
+}
+
+/**
+ * Advances the game by one frame.
+ *
+ * @param env
+ * @param action FLAP_FLAP to flap, FLAP_NOOP to glide.
+ * @param[out] reward Number of pipes passed during the frame, or NULL.
+ *
+ * @return 1 if the episode is over (Flappy crashed), 0 otherwise. Once it
+ * is over, steps do nothing until the next flap_reset().
+ */
+int flap_step(flap_env *env, int action, int *reward) {
+	int score = env->s.score;
+
+	if (!env->s.dead)
+		sim_step(&env->s, action == FLAP_FLAP ? INPUT_FLAP : INPUT_NONE);
+	if (reward)
+		*reward = env->s.score - score;
+	return env->s.dead;
+}
+
+/**
+ * Gets the number of pipes passed so far in the episode.
+ */
+int flap_score(const flap_env *env) {
+	return env->s.score;
+}
+
+/**
+ * Gets the size in bytes of a grid observation: rows x cols.
+ */
+size_t flap_grid_size(const flap_env *env) {
+	return (size_t) env->s.rows * env->s.cols;
+}
+
+/**
+ * Draws the current frame, row by row, into a buffer of the caller's. It
+ * holds the same characters the terminal would show; there is no
+ * terminating null.
+ *
+ * @param env
+ * @param[out] grid Receives flap_grid_size() characters.
+ * @param size Size of 'grid'.
+ *
+ * @return 0 on success, -1 if 'grid' is too small.
+ */
+int flap_observe_grid(const flap_env *env, char *grid, size_t size) {
+	cellbuf cb;
+
+	if (size < flap_grid_size(env))
+		return -1;
+
+	// Draw straight into the caller's buffer.
+	cb.rows = env->s.rows;
+	cb.cols = env->s.cols;
+	cb.cells = grid;
+	draw_game(&cb, &env->l, &env->s);
+	return 0;
+}
+
+/**
+ * Fills in the feature vector: where Flappy is and how it's moving, and
+ * where the opening of the next pipe is. See enum flap_feature.
+ *
+ * @param env
+ * @param[out] features Receives FLAP_NUM_FEATURES values.
+ * @param n Length of 'features'.
+ *
+ * @return 0 on success, -1 if 'features' is too short.
+ */
+int flap_observe_features(const flap_env *env, float *features, size_t n) {
+	const vpipe *p = sim_next_pipe(&env->s);
+
+	if (n < FLAP_NUM_FEATURES)
+		return -1;
+
+	features[FLAP_FEATURE_ROW] = (float) env->s.bird.y / ROW_SCALE;
+	features[FLAP_FEATURE_VELOCITY] = (float) env->s.bird.v / ROW_SCALE;
+	features[FLAP_FEATURE_PIPE_DX] = p->center - FLAPPY_COL;
+	features[FLAP_FEATURE_PIPE_TOP] = p->top_orow;
+	features[FLAP_FEATURE_PIPE_BOTTOM] = p->bottom_orow;
+	return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file
+ *
+ * The game as an environment for reinforcement learning, built into
+ * libflap.a and libflap.so ("make lib"). A training loop creates an
+ * environment, then calls flap_reset() at the start of every episode and
+ * flap_step() once per frame, reading observations with flap_observe_grid()
+ * or flap_observe_features() in between.
+ *
+ * Observations are written straight into buffers the caller owns, e.g. a
+ * NumPy array handed over with ctypes; nothing is allocated or copied per
+ * step. The grid is the exact frame the game would show, drawn by the same
+ * code as the terminal game.
+ */
+
+#ifndef FLAP_H
+#define FLAP_H
+
+#include <stddef.h>
+
+//-------------------------------- Definitions --------------------------------
+
+/**
+ * Marks what libflap.so exports. The library is built with hidden
+ * visibility, so the engine inside it stays out of callers' reach and can
+ * change without breaking them.
+ */
+#define FLAP_API __attribute__((visibility("default")))
+
+/** An environment: one game. Opaque to callers. */
+typedef struct flap_env flap_env;
+
+/** Actions flap_step() takes. */
+enum flap_action {
+	FLAP_NOOP = 0,
+	FLAP_FLAP = 1
+};
+
+/**
+ * Entries of the feature vector, in rows and columns of the board so they
+ * mean the same on every board size.
+ */
+enum flap_feature {
+	FLAP_FEATURE_ROW,         // Flappy's height, counting down from the top.
+	FLAP_FEATURE_VELOCITY,    // Rows per frame; negative is up.
+	FLAP_FEATURE_PIPE_DX,     // Columns from Flappy to the next pipe's center.
+	FLAP_FEATURE_PIPE_TOP,    // Top of the next pipe's opening: get_orow(p, 1).
+	FLAP_FEATURE_PIPE_BOTTOM, // Bottom of the opening: get_orow(p, 0).
+	FLAP_NUM_FEATURES
+};
+
+//---------------------------------- Functions --------------------------------
+
+FLAP_API flap_env *flap_new(int rows, int cols);
+FLAP_API void flap_free(flap_env *env);
+FLAP_API void flap_reset(flap_env *env, unsigned int seed);
+FLAP_API int flap_step(flap_env *env, int action, int *reward);
+FLAP_API int flap_score(const flap_env *env);
+FLAP_API size_t flap_grid_size(const flap_env *env);
+FLAP_API int flap_observe_grid(const flap_env *env, char *grid, size_t size);
+FLAP_API int flap_observe_features(const flap_env *env, float *features,
+		size_t n);
+
+#endif
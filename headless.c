@@ -0,0 +1,300 @@
+/**
+ * @file
+ *
+ * The modes that play without a terminal. See headless.h.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "corpus.h"
+#include "headless.h"
+#include "profile.h"
+#include "replay.h"
+#include "sim.h"
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Plays a batch of headless episodes and prints how they went.
+ *
+ * @return Exit status for the program.
+ */
+static int run_batch(const headless_options *opt) {
+	batch_config cfg;
+	episode_result *results;
+	struct timespec start, end;
+
+	cfg.episodes = opt->batch;
+	cfg.threads = opt->threads;
+	cfg.max_frames = opt->max_frames;
+	cfg.seed = opt->seed;
+	cfg.rows = NUM_ROWS;
+	cfg.cols = NUM_COLS;
+	cfg.scroll = opt->scroll;
+	cfg.profile = opt->profile;
+	cfg.policy = batch_policy;
+
+	results = calloc(cfg.episodes, sizeof(*results));
+	if (!results) {
+		fprintf(stderr, "flap: out of memory\n");
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (batch_run(&cfg, results)) {
+		fprintf(stderr, "flap: couldn't start worker threads\n");
+		free(results);
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	batch_report(stdout, &cfg, results, (end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9);
+	free(results);
+	return 0;
+}
+
+/**
+ * Plays back every episode of a replay file headless, with no pacing, and
+ * checks that each one ends with the recorded score.
+ *
+ * @return Exit status for the program: 0 if every episode checked out.
+ */
+static int run_replay(const headless_options *opt) {
+	unsigned char *data;
+	size_t len, off, n;
+	replay_episode ep;
+	game_state s;
+	int status, count = 0, ok = 0, bad = 0, skipped = 0;
+	long long frames = 0;
+	struct timespec start, end;
+	double seconds;
+
+	if (!(data = replay_read_file(opt->replay, &len))) {
+		fprintf(stderr, "flap: %s: %s\n", opt->replay, strerror(errno));
+		return 1;
+	}
+	if (replay_check_header(data, len)) {
+		fprintf(stderr, "flap: %s: not a replay file\n", opt->replay);
+		free(data);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (off = REPLAY_HEADER_LEN; off < len; off += n) {
+		if (!(n = replay_parse(data + off, len - off, &ep))) {
+			fprintf(stderr, "flap: %s: garbled record at byte %zu\n",
+					opt->replay, off);
+			bad++;
+			break;
+		}
+
+		status = replay_play(&ep, &s);
+		printf("episode %d: seed %u  %ux%u  frames %u  score %u  %s\n",
+				count++, ep.seed, ep.cols, ep.rows, ep.frames, ep.score,
+				status == 0 ? "ok" : status > 0 ? "MISMATCH" : "skipped");
+		if (status == 0) {
+			ok++;
+			frames += ep.frames;
+		}
+		else if (status > 0) {
+			bad++;
+		}
+		else {
+			skipped++;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("%d episodes: %d ok, %d mismatched, %d skipped; "
+			"%lld frames in %.3f s\n", count, ok, bad, skipped, frames, seconds);
+	free(data);
+	return bad ? 1 : 0;
+}
+
+/**
+ * Packs replay files into an archive for --score.
+ *
+ * @return Exit status for the program.
+ */
+static int run_pack(const headless_options *opt) {
+	const char *bad;
+	int n = corpus_pack(opt->pack, opt->inputs, opt->ninputs, &bad);
+
+	if (n < 0) {
+		fprintf(stderr, "flap: %s: %s\n", bad, errno == EINVAL ?
+				"not a replay file, or garbled" : strerror(errno));
+		return 1;
+	}
+	printf("packed %d episodes from %d files into %s\n", n, opt->ninputs,
+			opt->pack);
+	return 0;
+}
+
+/**
+ * Re-scores every episode of a replay archive on a pool of threads and
+ * prints the ones that no longer end as recorded.
+ *
+ * @return Exit status for the program: 0 if every episode checked out.
+ */
+static int run_score(const headless_options *opt) {
+	corpus c;
+	corpus_result *results;
+	replay_episode ep;
+	struct timespec start, end;
+	long long frames = 0;
+	int ok = 0, bad = 0, skipped = 0;
+	size_t i;
+	double seconds;
+
+	if (corpus_open(&c, opt->score)) {
+		fprintf(stderr, "flap: %s: %s\n", opt->score, errno == EINVAL ?
+				"not a replay archive" : strerror(errno));
+		return 1;
+	}
+	results = calloc(c.count ? c.count : 1, sizeof(*results));
+	if (!results) {
+		fprintf(stderr, "flap: out of memory\n");
+		corpus_close(&c);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (corpus_score(&c, opt->threads, results)) {
+		fprintf(stderr, "flap: couldn't start worker threads\n");
+		free(results);
+		corpus_close(&c);
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	for (i = 0; i < c.count; i++) {
+		frames += results[i].frames;
+		if (results[i].status == 0) {
+			ok++;
+		}
+		else if (results[i].status > 0) {
+			bad++;
+			corpus_episode(&c, i, &ep);
+			printf("episode %zu: seed %u  %dx%d  recorded frames %u score %u, "
+					"replayed frames %d score %d\n", i, ep.seed, ep.cols,
+					ep.rows, ep.frames, ep.score, results[i].frames,
+					results[i].score);
+		}
+		else {
+			skipped++;
+		}
+	}
+
+	printf("%zu episodes: %d ok, %d mismatched, %d skipped\n", c.count, ok,
+			bad, skipped);
+	printf("frames: %lld in %.3f s (%.0f frames/s) on %d threads\n", frames,
+			seconds, seconds > 0 ? frames / seconds : 0.0, opt->threads);
+	free(results);
+	corpus_close(&c);
+	return bad ? 1 : 0;
+}
+
+/**
+ * Tells whether the settings ask for a headless mode at all.
+ */
+int headless_wanted(const headless_options *opt) {
+	return opt->pack || opt->score || opt->replay || opt->batch;
+}
+
+/**
+ * Runs the headless mode the settings ask for: --pack, --score, --replay or
+ * --batch, whichever comes first in that list.
+ *
+ * @return Exit status for the program.
+ */
+int headless_run(const headless_options *opt) {
+	if (opt->pack)
+		return run_pack(opt);
+	if (opt->score)
+		return run_score(opt);
+	if (opt->replay)
+		return run_replay(opt);
+	return run_batch(opt);
+}
+
+/**
+ * Parses a non-negative integer command line argument.
+ *
+ * @return 0 on success, -1 if it isn't one.
+ */
+int headless_count(const char *arg, int *n) {
+	char *end;
+	long v = strtol(arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || v < 0 || v > INT_MAX)
+		return -1;
+	*n = v;
+	return 0;
+}
+
+/**
+ * Parses a seed command line argument: a number up to UINT_MAX, in decimal,
+ * octal or hex.
+ *
+ * @return 0 on success, -1 if it isn't a valid seed.
+ */
+int headless_seed(const char *arg, unsigned int *seed) {
+	char *end;
+	unsigned long v = strtoul(arg, &end, 0);
+	if (*arg == '\0' || *arg == '-' || *end != '\0' || v > UINT_MAX)
+		return -1;
+	*seed = v;
+	return 0;
+}
+
+/**
+ * Reads the difficulty profile for --profile, saying what's wrong with it
+ * if it can't be.
+ *
+ * @return 0 on success, -1 on error.
+ */
+int headless_load_profile(profile *p, const char *path) {
+	int line;
+
+	if (!profile_load(p, path, &line))
+		return 0;
+	if (line > 0)
+		fprintf(stderr, "flap: %s:%d: not a valid profile line\n", path, line);
+	else
+		fprintf(stderr, "flap: %s: %s\n", path, strerror(errno));
+	return -1;
+}
+
+/**
+ * Prints the help of the options for the headless modes, which flap and
+ * flap-batch take alike, for their usage messages.
+ */
+void headless_usage(FILE *out) {
+	fprintf(out,
+			"  --batch N       play N episodes headless and print a summary\n"
+			"  --threads T     worker threads for --batch and --score (default 1)\n"
+			"  --max-frames F  stop --batch episodes after F frames (default %d,\n"
+			"                  0 for no limit)\n"
+			"  --scroll C      move the pipes C columns per frame in --batch\n"
+			"                  episodes (default 1)\n"
+			"  --seed S        seed for the pipe openings (default: the time);\n"
+			"                  the same seed and inputs replay the same game\n"
+			"  --profile FILE  make the game harder as the score goes up, as\n"
+			"                  the difficulty profile in FILE says; it overrides\n"
+			"                  --scroll\n"
+			"  --replay FILE   replay the games in FILE headless and check\n"
+			"                  that they end as recorded\n"
+			"  --pack ARCHIVE  pack the games in the given replay files into a\n"
+			"                  replay archive\n"
+			"  --score ARCHIVE replay every game in a replay archive headless\n"
+			"                  and check that they end as recorded\n",
+			HEADLESS_MAX_FRAMES);
+}
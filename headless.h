@@ -0,0 +1,59 @@
+/**
+ * @file
+ *
+ * The modes that play without a terminal: --batch, --replay, --pack and
+ * --score. flap and the ncurses-free flap-batch both run them, and print
+ * their help, from here, so the two binaries can't drift apart.
+ */
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdio.h>
+
+#include "batch.h"
+#include "profile.h"
+
+/** Headless episodes are cut off after this many frames by default. */
+#define HEADLESS_MAX_FRAMES 100000
+
+/** Settings for the headless modes. */
+typedef struct headless_options {
+	/* Number of --batch episodes to play, or 0. */
+	int batch;
+
+	/* Worker threads for --batch and --score. */
+	int threads;
+
+	/* Frame limit per --batch episode; 0 for no limit. */
+	int max_frames;
+
+	/* Columns the pipes move per frame in --batch episodes. */
+	int scroll;
+
+	/* Seed of the first --batch episode. */
+	unsigned int seed;
+
+	/* Difficulty profile of the --batch episodes, or NULL. */
+	const profile *profile;
+
+	/* Replay file to play back and verify, or NULL. */
+	const char *replay;
+
+	/* Archive to pack the replay files 'inputs' into, or NULL. */
+	const char *pack;
+	char **inputs;
+	int ninputs;
+
+	/* Archive to re-score with 'threads' threads, or NULL. */
+	const char *score;
+} headless_options;
+
+int headless_wanted(const headless_options *opt);
+int headless_run(const headless_options *opt);
+int headless_count(const char *arg, int *n);
+int headless_seed(const char *arg, unsigned int *seed);
+int headless_load_profile(profile *p, const char *path);
+void headless_usage(FILE *out);
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file
+ *
+ * Difficulty profiles. See profile.h.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "sim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Parameters a profile can set. */
+enum profile_param {
+	PARAM_OPENING,
+	PARAM_OPENING_LOW,
+	PARAM_OPENING_HIGH,
+	PARAM_SPACING,
+	PARAM_SCROLL,
+	NUM_PARAMS
+};
+
+/** Most points on one curve. */
+#define MAX_POINTS 32
+
+/** A parameter's curve as read from the file. */
+typedef struct curve {
+	/* Number of points, or 0 if the file doesn't set the parameter. */
+	int npoints;
+
+	/* Line of the file it's on. */
+	int line;
+
+	/* The points, by increasing score. */
+	int score[MAX_POINTS];
+	double value[MAX_POINTS];
+} curve;
+
+//------------------------------ Global Constants -----------------------------
+
+/** Names of the parameters in the file, and the values they can take. */
+static const struct {
+	const char *name;
+	double min, max;
+} PARAMS[NUM_PARAMS] = {
+	[PARAM_OPENING]      = { "opening",      1, 64 },
+	[PARAM_OPENING_LOW]  = { "opening-low",  0, 1 },
+	[PARAM_OPENING_HIGH] = { "opening-high", 0, 1 },
+	[PARAM_SPACING]      = { "spacing",      1, 4096 },
+	[PARAM_SCROLL]       = { "scroll",       1, 32 }
+};
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Reads a line of a profile file, the given line number, into the curves.
+ *
+ * @return 0 on success, -1 if the line doesn't make sense.
+ */
+static int parse_line(char *line, int number, curve *curves) {
+	char *word = strtok(line, " \t\r\n"), *end;
+	curve *c;
+	long score;
+	double value;
+	int i;
+
+	if (!word || word[0] == '#')
+		return 0; // Blank or a comment.
+
+	for (i = 0; i < NUM_PARAMS && strcmp(word, PARAMS[i].name); i++)
+		;
+	if (i == NUM_PARAMS || curves[i].npoints > 0)
+		return -1; // Unknown, or set twice.
+	c = &curves[i];
+	c->line = number;
+
+	while ((word = strtok(NULL, " \t\r\n")) && word[0] != '#') {
+		score = strtol(word, &end, 10);
+		if (end == word || *end != ':' || score < 0 || score > 1000000 ||
+				(c->npoints > 0 && score <= c->score[c->npoints - 1]) ||
+				c->npoints == MAX_POINTS)
+			return -1;
+		word = end + 1;
+		value = strtod(word, &end);
+		if (end == word || *end || !(value >= PARAMS[i].min) ||
+				!(value <= PARAMS[i].max))
+			return -1;
+		c->score[c->npoints] = score;
+		c->value[c->npoints++] = value;
+	}
+	return c->npoints > 0 ? 0 : -1;
+}
+
+/**
+ * Gets the value of a curve at a score.
+ */
+static double curve_at(const curve *c, int score) {
+	int i;
+
+	if (score <= c->score[0])
+		return c->value[0];
+	for (i = 1; i < c->npoints; i++)
+		if (score < c->score[i])
+			return c->value[i - 1] + (c->value[i] - c->value[i - 1]) *
+					(score - c->score[i - 1]) /
+					(c->score[i] - c->score[i - 1]);
+	return c->value[c->npoints - 1];
+}
+
+/**
+ * Gets the value of a parameter at a score: its curve's, or the classic
+ * value if the file doesn't set it.
+ */
+static double param_at(const curve *curves, int param, int score) {
+	static const double CLASSIC_LOW = 0.25, CLASSIC_HIGH = 0.75;
+
+	if (curves[param].npoints > 0)
+		return curve_at(&curves[param], score);
+	switch (param) {
+	case PARAM_OPENING:
+		return OPENING_WIDTH;
+	case PARAM_OPENING_LOW:
+		return CLASSIC_LOW;
+	case PARAM_OPENING_HIGH:
+		return CLASSIC_HIGH;
+	case PARAM_SPACING:
+		return PIPE_SPACING;
+	default:
+		return 1;
+	}
+}
+
+/**
+ * Reads a profile file and works out the parameters at every score.
+ *
+ * @param[out] p Profile to fill in.
+ * @param path Profile file.
+ * @param[out] line Receives the number of the line that doesn't make sense,
+ * or 0 if the file couldn't be read.
+ *
+ * @return 0 on success, -1 with errno set on error (EINVAL if a line
+ * doesn't make sense).
+ */
+int profile_load(profile *p, const char *path, int *line) {
+	curve curves[NUM_PARAMS];
+	char buf[1024];
+	FILE *in;
+	int i;
+
+	*line = 0;
+	if (!(in = fopen(path, "r")))
+		return -1;
+	memset(curves, 0, sizeof(curves));
+	while (fgets(buf, sizeof(buf), in)) {
+		++*line;
+		if (parse_line(buf, *line, curves)) {
+			fclose(in);
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	if (ferror(in)) {
+		fclose(in);
+		*line = 0;
+		return -1;
+	}
+	fclose(in);
+
+	for (i = 0; i < PROFILE_LEVELS; i++) {
+		profile_level *lv = &p->levels[i];
+		float low = param_at(curves, PARAM_OPENING_LOW, i);
+		float high = param_at(curves, PARAM_OPENING_HIGH, i);
+
+		if (low > high) { // Blame whichever of the two came last.
+			*line = curves[PARAM_OPENING_LOW].line >
+					curves[PARAM_OPENING_HIGH].line ?
+					curves[PARAM_OPENING_LOW].line :
+					curves[PARAM_OPENING_HIGH].line;
+			errno = EINVAL;
+			return -1;
+		}
+		lv->opening_width = param_at(curves, PARAM_OPENING, i) + 0.5;
+		lv->opening_low = low;
+		lv->opening_range = high - low;
+		lv->spacing = param_at(curves, PARAM_SPACING, i) + 0.5;
+		lv->scroll = param_at(curves, PARAM_SCROLL, i) + 0.5;
+	}
+	return 0;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file
+ *
+ * Difficulty profiles, for --profile: how the pipes change as the score
+ * goes up. A profile file gives a curve for each parameter as points
+ * score:value, one parameter per line:
+ *
+ *     # The openings shrink from 9 rows to 5 over the first 40 pipes,
+ *     # while the pipes close in and, from 60 pipes on, speed up.
+ *     opening       0:9  40:5
+ *     spacing       0:44 40:30
+ *     scroll        0:1  59:1 60:2
+ *     opening-low   0:0.25
+ *     opening-high  0:0.75
+ *
+ * Between points a curve is a straight line, and before the first point and
+ * after the last it stays level. The parameters are:
+ *
+ *     opening       rows in the opening of each pipe
+ *     opening-low   lowest and highest height of the middle of an opening,
+ *     opening-high  as fractions of the board's height
+ *     spacing       columns between neighboring pipes
+ *     scroll        columns the pipes move every frame
+ *
+ * A parameter left out keeps its classic value, so an empty file gives the
+ * classic game. A pipe gets its opening from the score when it appears.
+ *
+ * The file is read once, into a table of every parameter at every score
+ * up to PROFILE_LEVELS. The game only ever looks up its score in the table,
+ * and only when a pipe appears or the score changes, never per frame.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+//-------------------------------- Definitions --------------------------------
+
+/** Scores the table covers; higher scores play like the last one. */
+#define PROFILE_LEVELS 256
+
+/** The game's parameters at one score. */
+typedef struct profile_level {
+	/* Rows in the openings of the pipes that appear. */
+	int opening_width;
+
+	/*
+	 * Openings are centered at a random fraction of the board's height,
+	 * at least opening_low and less than opening_low + opening_range.
+	 */
+	float opening_low, opening_range;
+
+	/* Columns between neighboring pipes, and columns they move per frame. */
+	int spacing, scroll;
+} profile_level;
+
+/** A profile, as a table of its parameters indexed by score. */
+typedef struct profile {
+	profile_level levels[PROFILE_LEVELS];
+} profile;
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Gets the parameters for a score.
+ */
+static inline const profile_level *profile_at(const profile *p, int score) {
+	return &p->levels[score < PROFILE_LEVELS ? score : PROFILE_LEVELS - 1];
+}
+
+int profile_load(profile *p, const char *path, int *line);
+
+#endif
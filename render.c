@@ -0,0 +1,104 @@
+/**
+ * @file
+ *
+ * Diffing renderer on top of ncurses. See render.h.
+ */
+
+#include <ncurses.h>
+#include <string.h>
+
+#include "render.h"
+
+/**
+ * Runs of changed cells separated by at most this many unchanged cells are
+ * sent as one run.
+ */
+static const int RUN_GAP = 3;
+
+/**
+ * Sets up a renderer for a screen of the given size. The first flush
+ * repaints every cell.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int render_init(renderer *r, int rows, int cols) {
+	r->stale = 1;
+	return cellbuf_init(&r->front, rows, cols);
+}
+
+/**
+ * Follows a change in the terminal size. The next flush repaints every
+ * cell.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int render_resize(renderer *r, int rows, int cols) {
+	r->stale = 1;
+	return cellbuf_resize(&r->front, rows, cols);
+}
+
+/**
+ * Releases the renderer's copy of the screen.
+ */
+void render_free(renderer *r) {
+	cellbuf_free(&r->front);
+}
+
+/**
+ * Forgets what is on the screen, so the next flush repaints every cell. Use
+ * this after something else wrote to the terminal.
+ */
+void render_invalidate(renderer *r) {
+	r->stale = 1;
+}
+
+/**
+ * Sends the cells of 'frame' that changed since the last flush and updates
+ * the terminal. Changed cells are grouped into runs along each row, and each
+ * run goes out with a single mvaddchnstr(). Unchanged cells between two
+ * nearby changes are resent rather than starting a new run, since moving the
+ * cursor costs about as much as a few characters.
+ *
+ * @param r
+ * @param frame Must be the same size the renderer was set up with.
+ *
+ * @return Number of cells sent to ncurses.
+ */
+int render_flush(renderer *r, const cellbuf *frame) {
+	chtype run[frame->cols];
+	int row, col, i, start, end, gap, sent = 0;
+
+	for (row = 0; row < frame->rows; row++) {
+		const char *next = &CELL(frame, row, 0);
+		char *shown = &CELL(&r->front, row, 0);
+
+		for (col = 0; col < frame->cols; col++) {
+			if (!r->stale && shown[col] == next[col])
+				continue;
+
+			// Extend the run over changed cells and short unchanged gaps.
+			start = col;
+			end = col + 1;
+			for (gap = 0, col++; col < frame->cols && gap <= RUN_GAP; col++) {
+				if (r->stale || shown[col] != next[col]) {
+					end = col + 1;
+					gap = 0;
+				}
+				else {
+					gap++;
+				}
+			}
+			col = end;
+
+			for (i = start; i < end; i++)
+				run[i - start] = (unsigned char) cell_ascii(next[i]);
+			mvaddchnstr(row, start, run, end - start);
+			memcpy(&shown[start], &next[start], end - start);
+			sent += end - start;
+		}
+	}
+	r->stale = 0;
+	refresh();
+
+	return sent;
+}
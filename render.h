@@ -0,0 +1,30 @@
+/**
+ * @file
+ *
+ * Gets frames composed in a cellbuf onto the ncurses screen. The renderer
+ * remembers what it last put on the terminal and only sends the cells that
+ * differ, so a frame where only the pipes shifted and Flappy moved costs a
+ * few dozen cells instead of a full repaint.
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "cellbuf.h"
+
+/** Diffing front end to ncurses. */
+typedef struct renderer {
+	/* Copy of what the terminal is currently showing. */
+	cellbuf front;
+
+	/* Nonzero if 'front' can't be trusted and everything must be sent. */
+	int stale;
+} renderer;
+
+int render_init(renderer *r, int rows, int cols);
+int render_resize(renderer *r, int rows, int cols);
+void render_free(renderer *r);
+void render_invalidate(renderer *r);
+int render_flush(renderer *r, const cellbuf *frame);
+
+#endif
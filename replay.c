@@ -0,0 +1,391 @@
+/**
+ * @file
+ *
+ * Recording and replaying input logs. See replay.h for the file format.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "replay.h"
+
+//------------------------------ Global Constants -----------------------------
+
+static const unsigned char REPLAY_MAGIC[4] = { 'F', 'L', 'P', 'R' };
+
+static const uint32_t REPLAY_VERSION = 1;
+
+/** Size of the fixed part of an episode record after its length field. */
+#define RECORD_FIXED_LEN 20
+
+/** Size of an episode record before its runs. */
+#define RECORD_HEAD_LEN (4 + RECORD_FIXED_LEN)
+
+/** Largest board a replay may ask for. */
+static const int REPLAY_MAX_SIDE = 4096;
+
+//---------------------------------- Functions --------------------------------
+
+static void put_u16(unsigned char *p, uint16_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static uint16_t get_u16(const unsigned char *p) {
+	return p[0] | p[1] << 8;
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+/**
+ * Writes all of 'len' bytes, retrying partial writes.
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int write_all(int fd, const unsigned char *data, size_t len) {
+	while (len > 0) {
+		ssize_t n = write(fd, data, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		data += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * Makes room for 'len' more bytes at the end of the record being put
+ * together.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+static int reserve(replay_writer *w, size_t len) {
+	size_t cap = w->rec_cap ? w->rec_cap : 256;
+	unsigned char *rec;
+
+	if (w->rec_cap - w->rec_len >= len)
+		return 0;
+	while (cap - w->rec_len < len)
+		cap *= 2;
+	if (!(rec = realloc(w->rec, cap)))
+		return -1;
+	w->rec = rec;
+	w->rec_cap = cap;
+	return 0;
+}
+
+/**
+ * Appends a LEB128 varint to the runs of the episode being recorded.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+static int push_varint(replay_writer *w, uint32_t v) {
+	if (reserve(w, 5))
+		return -1;
+	do {
+		unsigned char byte = v & 0x7f;
+		v >>= 7;
+		w->rec[w->rec_len++] = byte | (v ? 0x80 : 0);
+	} while (v);
+	return 0;
+}
+
+/**
+ * Opens a replay file for appending episodes, creating it if needed.
+ *
+ * @param[out] w Writer to set up.
+ * @param path
+ *
+ * @return 0 on success, -1 with errno set if the file couldn't be opened or
+ * isn't a replay file.
+ */
+int replay_open(replay_writer *w, const char *path) {
+	unsigned char header[REPLAY_HEADER_LEN];
+	struct stat st;
+
+	memset(w, 0, sizeof(*w));
+	w->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (w->fd < 0)
+		return -1;
+	if (fstat(w->fd, &st))
+		goto fail;
+
+	if (st.st_size == 0) {
+		memcpy(header, REPLAY_MAGIC, 4);
+		put_u32(header + 4, REPLAY_VERSION);
+		if (write_all(w->fd, header, sizeof(header)))
+			goto fail;
+	}
+	else if (pread(w->fd, header, sizeof(header), 0) != sizeof(header) ||
+			replay_check_header(header, sizeof(header))) {
+		errno = EINVAL;
+		goto fail;
+	}
+	return 0;
+
+fail:
+	close(w->fd);
+	w->fd = -1;
+	return -1;
+}
+
+/**
+ * Starts recording an episode that begins with the given (freshly started)
+ * round.
+ */
+void replay_begin(replay_writer *w, const game_state *s) {
+	w->seed = s->seed;
+	w->rows = s->rows;
+	w->cols = s->cols;
+	w->spacing = s->pipes.spacing;
+	w->flags = s->profile ? REPLAY_PROFILED : 0;
+	w->frames = 0;
+	w->rec_len = 0;
+	w->failed = 0;
+	if (reserve(w, RECORD_HEAD_LEN))
+		w->failed = 1;
+	else
+		w->rec_len = RECORD_HEAD_LEN;
+	w->run_input = INPUT_NONE;
+	w->run_len = 0;
+}
+
+/**
+ * Records the input given to sim_step() for one frame.
+ */
+void replay_frame(replay_writer *w, int input) {
+	input = input == INPUT_FLAP ? INPUT_FLAP : INPUT_NONE;
+	if (input != w->run_input) {
+		if (push_varint(w, w->run_len))
+			w->failed = 1;
+		w->run_input = input;
+		w->run_len = 0;
+	}
+	w->run_len++;
+	w->frames++;
+}
+
+/**
+ * Sets flags on the episode being recorded, e.g. REPLAY_RESIZED.
+ */
+void replay_mark(replay_writer *w, int flags) {
+	w->flags |= flags;
+}
+
+/**
+ * Finishes the episode being recorded and writes its record out with one
+ * write, so every game is on disk as soon as it's over and only the game in
+ * progress is lost if the program is killed.
+ *
+ * @param w
+ * @param s The game as it ended.
+ *
+ * @return 0 on success, -1 on error or if the record didn't fit in memory.
+ */
+int replay_end(replay_writer *w, const game_state *s) {
+	unsigned char *rec;
+
+	if (w->failed || push_varint(w, w->run_len))
+		return -1;
+	if (s->dead)
+		w->flags |= REPLAY_DIED;
+
+	rec = w->rec;
+	put_u32(rec, w->rec_len - 4);
+	put_u32(rec + 4, w->seed);
+	put_u16(rec + 8, w->rows);
+	put_u16(rec + 10, w->cols);
+	put_u16(rec + 12, w->spacing);
+	put_u16(rec + 14, w->flags);
+	put_u32(rec + 16, w->frames);
+	put_u32(rec + 20, s->score);
+	return write_all(w->fd, rec, w->rec_len);
+}
+
+/**
+ * Closes the replay file. Every record is written out as its episode ends,
+ * so there is nothing left to write.
+ *
+ * @return 0 on success, -1 on error.
+ */
+int replay_close(replay_writer *w) {
+	int status = close(w->fd) ? -1 : 0;
+
+	free(w->rec);
+	w->rec = NULL;
+	w->fd = -1;
+	return status;
+}
+
+/**
+ * Reads a whole replay file into memory.
+ *
+ * @param path
+ * @param[out] len Receives the size of the file.
+ *
+ * @return The file's bytes, to be freed by the caller, or NULL with errno
+ * set if the file couldn't be read.
+ */
+unsigned char *replay_read_file(const char *path, size_t *len) {
+	FILE *f = fopen(path, "rb");
+	unsigned char *data = NULL;
+	long size;
+
+	if (!f)
+		return NULL;
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 ||
+			fseek(f, 0, SEEK_SET))
+		goto done;
+	if (!(data = malloc(size ? size : 1)))
+		goto done;
+	if (fread(data, 1, size, f) != (size_t) size) {
+		free(data);
+		data = NULL;
+		errno = EIO;
+		goto done;
+	}
+	*len = size;
+
+done:
+	fclose(f);
+	return data;
+}
+
+/**
+ * Checks that a replay starts with a valid file header.
+ *
+ * @return 0 if it does, -1 otherwise.
+ */
+int replay_check_header(const unsigned char *data, size_t len) {
+	if (len < REPLAY_HEADER_LEN || memcmp(data, REPLAY_MAGIC, 4) ||
+			get_u32(data + 4) != REPLAY_VERSION)
+		return -1;
+	return 0;
+}
+
+/**
+ * Parses the episode record at the start of 'data'. The episode points into
+ * 'data'; nothing is copied.
+ *
+ * @param data
+ * @param len Bytes available at 'data'.
+ * @param[out] ep Receives the episode.
+ *
+ * @return Size of the record in bytes, or 0 if it is truncated or invalid.
+ */
+size_t replay_parse(const unsigned char *data, size_t len,
+		replay_episode *ep) {
+	uint32_t rec_len;
+
+	if (len < 4 + RECORD_FIXED_LEN)
+		return 0;
+	rec_len = get_u32(data);
+	if (rec_len < RECORD_FIXED_LEN || rec_len > len - 4)
+		return 0;
+
+	ep->seed = get_u32(data + 4);
+	ep->rows = get_u16(data + 8);
+	ep->cols = get_u16(data + 10);
+	ep->spacing = get_u16(data + 12);
+	ep->flags = get_u16(data + 14);
+	ep->frames = get_u32(data + 16);
+	ep->score = get_u32(data + 20);
+	ep->runs = data + 4 + RECORD_FIXED_LEN;
+	ep->runs_len = rec_len - RECORD_FIXED_LEN;
+
+	if (ep->rows < 3 || ep->rows > REPLAY_MAX_SIDE ||
+			ep->cols < 1 || ep->cols > REPLAY_MAX_SIDE || ep->spacing < 1)
+		return 0;
+	return 4 + rec_len;
+}
+
+/**
+ * Starts decoding the inputs of an episode from its first frame.
+ */
+void replay_cursor_init(replay_cursor *c, const replay_episode *ep) {
+	c->p = ep->runs;
+	c->end = ep->runs + ep->runs_len;
+
+	// The first run is of INPUT_NONE; each run flips the input.
+	c->input = INPUT_FLAP;
+	c->left = 0;
+}
+
+/**
+ * Gets the input of the next frame.
+ *
+ * @return INPUT_FLAP or INPUT_NONE, or -1 if the runs are used up or
+ * garbled.
+ */
+int replay_next_input(replay_cursor *c) {
+	while (c->left == 0) {
+		uint32_t v = 0;
+		int shift = 0;
+		unsigned char byte;
+
+		do {
+			if (c->p >= c->end || shift > 28)
+				return -1;
+			byte = *c->p++;
+			v |= (uint32_t) (byte & 0x7f) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+
+		c->left = v;
+		c->input = c->input == INPUT_FLAP ? INPUT_NONE : INPUT_FLAP;
+	}
+	c->left--;
+	return c->input;
+}
+
+/**
+ * Plays an episode back headless, as fast as the CPU allows.
+ *
+ * @param ep Episode to play.
+ * @param[out] s Receives the game as it ended.
+ *
+ * @return 0 if the game ended exactly as recorded, 1 if it didn't, -1 if
+ * the episode can't be replayed (garbled, or the board was resized or
+ * followed a profile).
+ */
+int replay_play(const replay_episode *ep, game_state *s) {
+	replay_cursor c;
+	uint32_t f;
+	int input;
+
+	if (ep->flags & (REPLAY_RESIZED | REPLAY_PROFILED))
+		return -1;
+
+	sim_init(s, ep->rows, ep->cols, ep->seed);
+	if (ep->spacing != s->pipes.spacing)
+		sim_set_spacing(s, ep->spacing);
+
+	replay_cursor_init(&c, ep);
+	for (f = 0; f < ep->frames; f++) {
+		if ((input = replay_next_input(&c)) < 0)
+			return -1;
+		if (s->dead)
+			return 1; // Died sooner than recorded.
+		sim_step(s, input);
+	}
+
+	return (uint32_t) s->score == ep->score &&
+			!s->dead == !(ep->flags & REPLAY_DIED) ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file
+ *
+ * Compact input logs for replaying games deterministically. A round of the
+ * game is completely described by its seed, its board and the per-frame
+ * INPUT_FLAP / INPUT_NONE decisions, so a replay stores just that, with the
+ * decisions run-length encoded. At a flap every dozen or so frames this
+ * comes to one or two bits per frame.
+ *
+ * A replay file is a file header followed by episode records, all integers
+ * little-endian:
+ *
+ *     file header:  "FLPR" u32 version
+ *     record:       u32 length of the rest of the record
+ *                   u32 seed  u16 rows  u16 cols  u16 spacing  u16 flags
+ *                   u32 frames  u32 score
+ *                   runs
+ *
+ * 'runs' are LEB128 varints giving the lengths of alternating runs of
+ * INPUT_NONE and INPUT_FLAP frames, starting with INPUT_NONE (a run may be
+ * empty). 'frames' and 'score' are what the recorded game ended with, for
+ * verification.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Flags of an episode record. */
+enum replay_flags {
+	/* Flappy died at the end of the episode (instead of the user quitting). */
+	REPLAY_DIED = 1,
+
+	/* The board was resized during the episode, so it can't be replayed. */
+	REPLAY_RESIZED = 2,
+
+	/*
+	 * The episode followed a difficulty profile, which isn't recorded, so it
+	 * can't be replayed either.
+	 */
+	REPLAY_PROFILED = 4
+};
+
+/**
+ * Appends episodes to a replay file. Each episode's record is put together
+ * in memory and written out with one write when the episode ends.
+ */
+typedef struct replay_writer {
+	/* File descriptor of the replay file, opened for appending. */
+	int fd;
+
+	/* The episode being recorded: fields of its record so far. */
+	uint32_t seed;
+	uint16_t rows, cols, spacing, flags;
+	uint32_t frames;
+
+	/*
+	 * The record being put together: room for its length and fixed fields,
+	 * filled in at the end, then the encoded runs so far. And the run in
+	 * progress.
+	 */
+	unsigned char *rec;
+	size_t rec_len, rec_cap;
+	int run_input;
+	uint32_t run_len;
+
+	/* Nonzero if memory for the record ran out. */
+	int failed;
+} replay_writer;
+
+/** One episode of a replay, pointing into the replay's bytes. */
+typedef struct replay_episode {
+	uint32_t seed;
+	int rows, cols, spacing, flags;
+	uint32_t frames, score;
+
+	/* Encoded runs; see replay_cursor. */
+	const unsigned char *runs;
+	size_t runs_len;
+} replay_episode;
+
+/** Decodes the inputs of an episode one frame at a time. */
+typedef struct replay_cursor {
+	const unsigned char *p, *end;
+	int input;
+	uint32_t left;
+} replay_cursor;
+
+//------------------------------ Global Constants -----------------------------
+
+/** Size of the file header at the start of every replay file. */
+#define REPLAY_HEADER_LEN 8
+
+//---------------------------------- Functions --------------------------------
+
+int replay_open(replay_writer *w, const char *path);
+void replay_begin(replay_writer *w, const game_state *s);
+void replay_frame(replay_writer *w, int input);
+void replay_mark(replay_writer *w, int flags);
+int replay_end(replay_writer *w, const game_state *s);
+int replay_close(replay_writer *w);
+
+unsigned char *replay_read_file(const char *path, size_t *len);
+int replay_check_header(const unsigned char *data, size_t len);
+size_t replay_parse(const unsigned char *data, size_t len,
+		replay_episode *ep);
+void replay_cursor_init(replay_cursor *c, const replay_episode *ep);
+int replay_next_input(replay_cursor *c);
+int replay_play(const replay_episode *ep, game_state *s);
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * @file
+ *
+ * flap-batch: the headless modes of flap on their own, for machines with no
+ * terminal or no ncurses. It plays, replays and re-scores games exactly as
+ * flap does, from the same code (see headless.h), and takes the same
+ * options for them.
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "headless.h"
+#include "profile.h"
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Prints the command line usage.
+ */
+void usage(FILE *out) {
+	fprintf(out,
+			"Usage: flap-batch --batch N [options]\n"
+			"       flap-batch --replay FILE\n"
+			"       flap-batch --score ARCHIVE [--threads T]\n"
+			"       flap-batch --pack ARCHIVE REPLAY...\n");
+	headless_usage(out);
+	fprintf(out, "  --help          show this message\n");
+}
+
+/**
+ * Parses a non-negative integer command line argument, or exits with a
+ * usage message if it isn't one.
+ */
+int parse_count(const char *name, const char *arg) {
+	int n;
+	if (headless_count(arg, &n)) {
+		fprintf(stderr, "flap-batch: %s needs a non-negative number, "
+				"not '%s'\n", name, arg);
+		usage(stderr);
+		exit(2);
+	}
+	return n;
+}
+
+//------------------------------------ Main -----------------------------------
+
+int main(int argc, char **argv)
+{
+	static const struct option longopts[] = {
+		{ "batch",      required_argument, NULL, 'b' },
+		{ "threads",    required_argument, NULL, 't' },
+		{ "max-frames", required_argument, NULL, 'm' },
+		{ "scroll",     required_argument, NULL, 'x' },
+		{ "seed",       required_argument, NULL, 's' },
+		{ "profile",    required_argument, NULL, 'f' },
+		{ "replay",     required_argument, NULL, 'p' },
+		{ "pack",       required_argument, NULL, 'a' },
+		{ "score",      required_argument, NULL, 'c' },
+		{ "help",       no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+	static profile prof;
+	headless_options opt;
+	int c;
+
+	opt.batch = 0;
+	opt.threads = 1;
+	opt.max_frames = HEADLESS_MAX_FRAMES;
+	opt.scroll = 1;
+	opt.seed = time(NULL);
+	opt.profile = NULL;
+	opt.replay = NULL;
+	opt.pack = NULL;
+	opt.score = NULL;
+
+	while ((c = getopt_long(argc, argv, "", longopts, NULL)) != -1) {
+		switch (c) {
+		case 'b':
+			opt.batch = parse_count("--batch", optarg);
+			break;
+		case 't':
+			opt.threads = parse_count("--threads", optarg);
+			break;
+		case 'm':
+			opt.max_frames = parse_count("--max-frames", optarg);
+			break;
+		case 'x':
+			opt.scroll = parse_count("--scroll", optarg);
+			break;
+		case 's':
+			if (headless_seed(optarg, &opt.seed)) {
+				fprintf(stderr, "flap-batch: --seed needs a number up to %u, "
+						"not '%s'\n", UINT_MAX, optarg);
+				usage(stderr);
+				return 2;
+			}
+			break;
+		case 'f':
+			if (headless_load_profile(&prof, optarg))
+				return 1;
+			opt.profile = &prof;
+			break;
+		case 'p':
+			opt.replay = optarg;
+			break;
+		case 'a':
+			opt.pack = optarg;
+			break;
+		case 'c':
+			opt.score = optarg;
+			break;
+		case 'h':
+			usage(stdout);
+			return 0;
+		default:
+			usage(stderr);
+			return 2;
+		}
+	}
+
+	// Only --pack takes more arguments: the replay files to pack.
+	opt.inputs = argv + optind;
+	opt.ninputs = argc - optind;
+	if (!headless_wanted(&opt) ||
+			(opt.pack ? opt.ninputs == 0 : opt.ninputs > 0) ||
+			opt.threads < 1 || opt.scroll < 1) {
+		usage(stderr);
+		return 2;
+	}
+	return headless_run(&opt);
+}
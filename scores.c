@@ -0,0 +1,359 @@
+/**
+ * @file
+ *
+ * High-score store. See scores.h.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "scores.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Start of the file; the records follow. */
+typedef struct score_header {
+	char magic[8];
+
+	/* Number of records. */
+	uint32_t count;
+
+	/* Size of a record, so files from another build are recognized. */
+	uint32_t record_size;
+} score_header;
+
+//------------------------------ Global Constants -----------------------------
+
+static const char SCORES_MAGIC[8] = "FLAPSCO1";
+
+/** Most players in a file; scores_flush() keeps the best ones. */
+static const int MAX_RECORDS = 100000;
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Forgets the mapped version of the file.
+ */
+static void unmap(score_store *st) {
+	if (st->map)
+		munmap(st->map, st->map_len);
+	st->map = NULL;
+	st->map_len = 0;
+	st->dev = 0;
+	st->ino = 0;
+	st->records = NULL;
+	st->nrecords = 0;
+}
+
+/**
+ * Opens a score file, which is created by the first scores_flush() if it
+ * doesn't exist yet.
+ *
+ * @param[out] st Store to set up.
+ * @param path Score file.
+ *
+ * @return 0 on success, -1 with errno set if the file can't be read or isn't
+ * a score file.
+ */
+int scores_open(score_store *st, const char *path) {
+	memset(st, 0, sizeof(*st));
+	st->path = path;
+	return scores_refresh(st);
+}
+
+void scores_close(score_store *st) {
+	unmap(st);
+	free(st->pending);
+	st->pending = NULL;
+	st->npending = st->cap = 0;
+}
+
+/**
+ * Maps the latest version of the file, unless it's the one mapped already.
+ * Costs a stat() when nothing changed.
+ *
+ * @return 0 on success, -1 with errno set on error, when the last version
+ * mapped stays mapped.
+ */
+int scores_refresh(score_store *st) {
+	const score_header *h;
+	struct stat sb;
+	void *map;
+	int fd;
+
+	if (stat(st->path, &sb)) {
+		if (errno != ENOENT)
+			return -1;
+		unmap(st);
+		return 0;
+	}
+	if (st->map && sb.st_dev == st->dev && sb.st_ino == st->ino)
+		return 0;
+
+	if ((fd = open(st->path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	if (fstat(fd, &sb)) {
+		close(fd);
+		return -1;
+	}
+	if (sb.st_size < (off_t) sizeof(*h)) {
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+	map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	h = map;
+	if (memcmp(h->magic, SCORES_MAGIC, sizeof(h->magic)) ||
+			h->record_size != sizeof(score_record) ||
+			h->count > (uint64_t) (sb.st_size - sizeof(*h)) /
+					sizeof(score_record)) {
+		munmap(map, sb.st_size);
+		errno = EINVAL;
+		return -1;
+	}
+
+	unmap(st);
+	st->map = map;
+	st->map_len = sb.st_size;
+	st->dev = sb.st_dev;
+	st->ino = sb.st_ino;
+	st->records = (const score_record *) (h + 1);
+	st->nrecords = h->count;
+	return 0;
+}
+
+/**
+ * Finds a player's record in an array of them.
+ *
+ * @return The record, or NULL if they don't have one.
+ */
+static const score_record *find(const score_record *records, int n,
+		const char *name) {
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (!strncmp(records[i].name, name, SCORE_NAME_LEN - 1))
+			return &records[i];
+	return NULL;
+}
+
+/**
+ * Gets a player's best score, counting the scores not written yet.
+ *
+ * @return The best score, or 0 if they never played.
+ */
+int scores_best(const score_store *st, const char *name) {
+	const score_record *saved = find(st->records, st->nrecords, name);
+	const score_record *queued = find(st->pending, st->npending, name);
+	int best = saved ? saved->best : 0;
+
+	if (queued && queued->best > best)
+		best = queued->best;
+	return best;
+}
+
+/**
+ * Queues the score of a finished game for the next scores_flush().
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int scores_submit(score_store *st, const char *name, int score) {
+	score_record *r = (score_record *) find(st->pending, st->npending, name);
+
+	if (!r) {
+		if (st->npending == st->cap) {
+			int cap = st->cap ? 2 * st->cap : 8;
+			score_record *pending = realloc(st->pending, cap * sizeof(*pending));
+			if (!pending)
+				return -1;
+			st->pending = pending;
+			st->cap = cap;
+		}
+		r = &st->pending[st->npending++];
+		memset(r, 0, sizeof(*r));
+		strncpy(r->name, name, SCORE_NAME_LEN - 1);
+	}
+	if (score > r->best)
+		r->best = score;
+	r->games++;
+	return 0;
+}
+
+/**
+ * Orders records best score first, and by name among equal scores.
+ */
+static int by_best(const void *a, const void *b) {
+	const score_record *ra = a, *rb = b;
+
+	if (ra->best != rb->best)
+		return ra->best > rb->best ? -1 : 1;
+	return strncmp(ra->name, rb->name, SCORE_NAME_LEN);
+}
+
+/**
+ * Writes all of a buffer, riding out signals and short writes.
+ *
+ * @return 0 on success, -1 with errno set on error.
+ */
+static int write_all(int fd, const void *data, size_t len) {
+	const char *p = data;
+
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * Writes a new version of the file to a temporary file next to it and
+ * renames that into place.
+ *
+ * @return 0 on success, -1 with errno set on error.
+ */
+static int replace_file(const char *path, const score_record *records,
+		int n) {
+	score_header h;
+	size_t len = strlen(path), size = n * sizeof(*records);
+	char *tmp = malloc(len + 8);
+	int fd = -1, saved;
+
+	if (!tmp)
+		return -1;
+	memcpy(tmp, path, len);
+	memcpy(tmp + len, ".XXXXXX", 8);
+	if ((fd = mkstemp(tmp)) < 0)
+		goto fail;
+
+	memcpy(h.magic, SCORES_MAGIC, sizeof(h.magic));
+	h.count = n;
+	h.record_size = sizeof(score_record);
+	if (fchmod(fd, 0644) || write_all(fd, &h, sizeof(h)) ||
+			write_all(fd, records, size) || fsync(fd))
+		goto fail;
+	if (close(fd)) {
+		fd = -1;
+		goto fail;
+	}
+	fd = -1;
+	if (rename(tmp, path))
+		goto fail;
+	free(tmp);
+	return 0;
+
+fail:
+	saved = errno;
+	if (fd >= 0)
+		close(fd);
+	unlink(tmp);
+	free(tmp);
+	errno = saved;
+	return -1;
+}
+
+/**
+ * Writes the queued scores to the file, merging them into whatever other
+ * games wrote meanwhile, once it's this writer's turn.
+ *
+ * @param st Store to write.
+ * @param nowait Nonzero to give up if another writer has the file.
+ *
+ * @return 0 on success, -1 with errno set on error, when the scores stay
+ * queued for the next try.
+ */
+static int flush(score_store *st, int nowait) {
+	score_record *merged = NULL;
+	const score_record *old;
+	char *lock_path;
+	int lock, i, n, status = -1, saved;
+
+	if (st->npending == 0)
+		return 0;
+
+	// Writers take turns; each merges into what the last one wrote.
+	if (!(lock_path = malloc(strlen(st->path) + 6)))
+		return -1;
+	sprintf(lock_path, "%s.lock", st->path);
+	lock = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	free(lock_path);
+	if (lock < 0)
+		return -1;
+	if (flock(lock, nowait ? LOCK_EX | LOCK_NB : LOCK_EX) ||
+			scores_refresh(st))
+		goto done;
+
+	if (!(merged = malloc((st->nrecords + st->npending) * sizeof(*merged))))
+		goto done;
+	if ((n = st->nrecords) > 0)
+		memcpy(merged, st->records, n * sizeof(*merged));
+	for (i = 0; i < st->npending; i++) {
+		const score_record *p = &st->pending[i];
+		score_record *r;
+		if ((old = find(st->records, st->nrecords, p->name))) {
+			r = &merged[old - st->records];
+			if (p->best > r->best)
+				r->best = p->best;
+			r->games += p->games;
+		}
+		else {
+			merged[n++] = *p;
+		}
+	}
+	qsort(merged, n, sizeof(*merged), by_best);
+	if (n > MAX_RECORDS)
+		n = MAX_RECORDS;
+
+	if (replace_file(st->path, merged, n))
+		goto done;
+	st->npending = 0;
+	status = scores_refresh(st);
+
+done:
+	saved = errno;
+	free(merged);
+	close(lock); // Releases the lock.
+	errno = saved;
+	return status;
+}
+
+/**
+ * Writes the queued scores to the file, merging them into whatever other
+ * games wrote meanwhile. Readers aren't held up: they go on reading the
+ * version they mapped until they next call scores_refresh(). Waits for its
+ * turn if another game or server is writing the file.
+ *
+ * @return 0 on success, -1 with errno set on error, when the scores stay
+ * queued for the next try.
+ */
+int scores_flush(score_store *st) {
+	return flush(st, 0);
+}
+
+/**
+ * Writes the queued scores like scores_flush(), unless another game or
+ * server is writing the file: then it doesn't wait, for whoever can't
+ * afford to, e.g. a server with other players to keep ticking.
+ *
+ * @return 0 on success, -1 with errno set on error, when the scores stay
+ * queued for the next try. errno is EWOULDBLOCK if the file was busy.
+ */
+int scores_try_flush(score_store *st) {
+	return flush(st, 1);
+}
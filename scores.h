@@ -0,0 +1,69 @@
+/**
+ * @file
+ *
+ * High-score store, for --scores: every player's best score and number of
+ * games, in a file that any number of games and servers can share.
+ *
+ * The file is a header followed by fixed-size records sorted best score
+ * first, so the leaderboard is simply the first few records. It is only
+ * ever replaced as a whole: a new version is written to a temporary file
+ * and renamed over the old one. Readers therefore map the file and read
+ * the records in place, without parsing anything or taking any lock, and
+ * always see a complete version. Writers take a lock on a file next to it,
+ * merge their scores into the latest version and rename theirs into place.
+ *
+ * Scores are queued with scores_submit() and written in one go with
+ * scores_flush(), which games call when a game ends, never per frame.
+ * scores_try_flush() does the same but never waits for another writer.
+ */
+
+#ifndef SCORES_H
+#define SCORES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+//-------------------------------- Definitions --------------------------------
+
+/** Longest player name kept, including the terminating null. */
+#define SCORE_NAME_LEN 32
+
+/** One player's line in the file. */
+typedef struct score_record {
+	char name[SCORE_NAME_LEN];
+	int32_t best;
+	int32_t games;
+} score_record;
+
+/** An open score file and the scores not written to it yet. */
+typedef struct score_store {
+	const char *path;
+
+	/*
+	 * The version of the file mapped, which file that was, and its
+	 * records, best first.
+	 */
+	void *map;
+	size_t map_len;
+	dev_t dev;
+	ino_t ino;
+	const score_record *records;
+	int nrecords;
+
+	/* Scores queued by scores_submit(), one entry per player. */
+	score_record *pending;
+	int npending, cap;
+} score_store;
+
+//---------------------------------- Functions --------------------------------
+
+int scores_open(score_store *st, const char *path);
+void scores_close(score_store *st);
+int scores_refresh(score_store *st);
+int scores_best(const score_store *st, const char *name);
+int scores_submit(score_store *st, const char *name, int score);
+int scores_flush(score_store *st);
+int scores_try_flush(score_store *st);
+
+#endif
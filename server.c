@@ -0,0 +1,705 @@
+/**
+ * @file
+ *
+ * Multi-session game server. See server.h.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ansi.h"
+#include "backend.h"
+#include "scores.h"
+#include "server.h"
+#include "session.h"
+#include "sim.h"
+#include "text.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Kinds of things epoll reports on. */
+enum source_kind {
+	SOURCE_LISTENER,
+	SOURCE_TIMER,
+	SOURCE_SIGNALS,
+	SOURCE_CLIENT
+};
+
+/** A file descriptor registered with epoll, and what it is. */
+typedef struct source {
+	int fd;
+	enum source_kind kind;
+} source;
+
+/** How far through a telnet command the input parser is. */
+enum telnet_state {
+	TELNET_DATA,
+	TELNET_IAC,        // After IAC.
+	TELNET_OPTION,     // After IAC WILL, WONT, DO or DONT.
+	TELNET_SB,         // In a subnegotiation.
+	TELNET_SB_IAC      // After IAC in a subnegotiation.
+};
+
+/** One player's connection and game. */
+typedef struct client {
+	/* Must come first: epoll hands back a pointer to it. */
+	source src;
+
+	/* The server, and the client's position in its list of clients. */
+	struct server *sv;
+	int index;
+
+	/* Nonzero once the connection is done with, to be dropped. */
+	int gone;
+
+	/* Name the player's scores go under: their address. */
+	char name[SCORE_NAME_LEN];
+
+	/*
+	 * The player's session, which goes on to MODE_QUIT while the goodbye is
+	 * being sent, and what their terminal shows.
+	 */
+	session ss;
+	ansi_renderer r;
+
+	/*
+	 * Window size the client reported last, which the next tick applies
+	 * when 'in' says it changed.
+	 */
+	int new_rows, new_cols;
+
+	/*
+	 * Keys pressed since the last tick, all of which the next tick handles
+	 * at once, as the interactive game does.
+	 */
+	term_input in;
+
+	/* Input parser state: telnet commands and escape sequences. */
+	enum telnet_state telnet;
+	unsigned char sb[8];
+	int sb_len;
+	key_decoder keys;
+
+	/*
+	 * Output of earlier frames that the socket didn't take yet, and this
+	 * frame's output. While anything is pending no new frames are emitted;
+	 * the diff renderer catches up in one go once the socket drains.
+	 */
+	outbuf pending;
+	outbuf out;
+} client;
+
+/** Everything the server is juggling. */
+typedef struct server {
+	const server_config *cfg;
+	int epfd;
+	source listener, timer, signals;
+
+	client **clients;
+	int nclients;
+
+	/* Seed of the next player's first game. */
+	unsigned int next_seed;
+
+	/* Ticks since the high scores were last written. */
+	int score_ticks;
+} server;
+
+//------------------------------ Global Constants -----------------------------
+
+/** Most ticks one timer wakeup catches up on. */
+static const int SERVER_MAX_CATCHUP = 5;
+
+/** Ticks between writes of the high scores, while there are any to write. */
+static const int SCORE_FLUSH_TICKS = 5 * SESSION_FPS;
+
+/** Telnet: IAC WILL ECHO, IAC WILL SUPPRESS-GO-AHEAD, IAC DO NAWS. */
+static const char TELNET_HELLO[] = "\377\373\001\377\373\003\377\375\037";
+
+/** Telnet commands and options the parser cares about. */
+static const unsigned char IAC = 255, SB = 250, SE = 240, OPT_NAWS = 31;
+
+/** Sent when a player arrives: hide the cursor. */
+static const char ANSI_HELLO[] = "\033[?25l";
+
+/** Sent when a player leaves: show the cursor, clear the screen. */
+static const char ANSI_BYE[] = "\033[?25h\033[H\033[2J";
+
+/**
+ * Most ticks a leaving player's connection stays open to get the output
+ * still pending and the goodbye out, and most milliseconds the server
+ * waits for all of them when it shuts down.
+ */
+static const int LINGER_TICKS = 2 * SESSION_FPS;
+static const int LINGER_MS = 1000;
+
+//---------------------------------- Functions --------------------------------
+
+static int set_nonblocking(int fd) {
+	int flags = fcntl(fd, F_GETFL);
+	return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int watch(server *sv, source *src, uint32_t events) {
+	struct epoll_event ev;
+
+	ev.events = events;
+	ev.data.ptr = src;
+	return epoll_ctl(sv->epfd, EPOLL_CTL_ADD, src->fd, &ev);
+}
+
+/**
+ * Writes as much of a list of buffers to a non-blocking socket as it takes
+ * and keeps the rest in 'pending'.
+ *
+ * @return 0 on success, -1 if the connection is broken.
+ */
+static int send_iov(client *c, struct iovec *iov, int n) {
+	ssize_t sent = writev(c->src.fd, iov, n);
+	int i;
+
+	if (sent < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			return -1;
+		sent = 0;
+	}
+
+	for (i = 0; i < n; i++) {
+		size_t len = iov[i].iov_len;
+		if ((size_t) sent >= len) {
+			sent -= len;
+			continue;
+		}
+		outbuf_put(&c->pending, (char *) iov[i].iov_base + sent, len - sent);
+		sent = 0;
+	}
+	return c->pending.failed ? -1 : 0;
+}
+
+/**
+ * Tries to get rid of the output that is still pending.
+ *
+ * @return 0 on success, -1 if the connection is broken.
+ */
+static int send_pending(client *c) {
+	ssize_t sent;
+
+	if (c->pending.len == 0)
+		return 0;
+	sent = write(c->src.fd, c->pending.data, c->pending.len);
+	if (sent < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ?
+				0 : -1;
+	memmove(c->pending.data, c->pending.data + sent, c->pending.len - sent);
+	c->pending.len -= sent;
+	return 0;
+}
+
+/**
+ * Sends the changes from the last frame sent to the client's current
+ * frame, unless the socket is still busy with earlier output.
+ *
+ * @return 0 on success, -1 if the connection is broken.
+ */
+static int send_frame(client *c) {
+	struct iovec iov[3];
+
+	if (send_pending(c))
+		return -1;
+	if (c->pending.len > 0)
+		return 0; // Try again next tick.
+
+	c->out.len = 0;
+	ansi_flush(&c->r, &c->ss.frame, &c->out);
+	if (c->out.failed)
+		return -1;
+	if (c->out.len == 0)
+		return 0;
+
+	iov[0].iov_base = (void *) ANSI_SYNC_BEGIN;
+	iov[0].iov_len = strlen(ANSI_SYNC_BEGIN);
+	iov[1].iov_base = c->out.data;
+	iov[1].iov_len = c->out.len;
+	iov[2].iov_base = (void *) ANSI_SYNC_END;
+	iov[2].iov_len = strlen(ANSI_SYNC_END);
+	return send_iov(c, iov, 3);
+}
+
+/**
+ * Sends a fixed message, e.g. control sequences, after whatever is pending.
+ *
+ * @return 0 on success, -1 if the connection is broken.
+ */
+static int send_text(client *c, const char *text, size_t len) {
+	struct iovec iov;
+
+	if (c->pending.len > 0) {
+		outbuf_put(&c->pending, text, len);
+		return send_pending(c);
+	}
+	iov.iov_base = (void *) text;
+	iov.iov_len = len;
+	return send_iov(c, &iov, 1);
+}
+
+/**
+ * Fits a client's session and what their terminal shows to its size, which
+ * is the default board size until the client reports its own.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+static int client_fit(client *c, int rows, int cols) {
+	return session_resize(&c->ss, rows, cols) ||
+			ansi_resize(&c->r, rows, cols) ? -1 : 0;
+}
+
+/**
+ * Sends a client their session's frame; see send_frame(). A broken
+ * connection is dropped.
+ */
+static void client_show(session *ss) {
+	client *c = ss->ctx;
+
+	if (send_frame(c))
+		c->gone = 1;
+}
+
+/**
+ * Queues the score of a client's game that just ended; tick_scores()
+ * writes it out.
+ */
+static void client_game_over(session *ss) {
+	client *c = ss->ctx;
+	score_store *st = c->sv->cfg->scores;
+
+	if (st)
+		scores_submit(st, c->name, ss->s.score);
+}
+
+/** How a client's session gets its frames out and its scores in. */
+static const session_hooks client_hooks = { client_show, client_game_over };
+
+static void client_free(client *c) {
+	close(c->src.fd);
+	session_free(&c->ss);
+	ansi_free(&c->r);
+	outbuf_free(&c->pending);
+	outbuf_free(&c->out);
+	free(c);
+}
+
+/**
+ * Hangs up on a client and forgets it. Only call this between batches of
+ * epoll events, as the batch may still point to the client; set 'gone' and
+ * let reap_clients() do it instead.
+ */
+static void drop_client(server *sv, client *c) {
+	int i = c->index;
+
+	sv->clients[i] = sv->clients[--sv->nclients];
+	sv->clients[i]->index = i;
+	client_free(c);
+}
+
+/**
+ * Drops the clients that are done with.
+ */
+static void reap_clients(server *sv) {
+	int i;
+
+	for (i = sv->nclients - 1; i >= 0; i--)
+		if (sv->clients[i]->gone)
+			drop_client(sv, sv->clients[i]);
+}
+
+/**
+ * Accepts a waiting connection and starts its player on the splash screen.
+ */
+static void accept_client(server *sv) {
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	client *c, **clients;
+	int fd, one = 1;
+
+	fd = accept(sv->listener.fd, (struct sockaddr *) &addr, &addr_len);
+	if (fd < 0)
+		return;
+
+	if (sv->nclients >= sv->cfg->max_clients) {
+		char full[128];
+		int len = snprintf(full, sizeof(full), "%s\r\n",
+				text(TEXT_SERVER_FULL));
+		// Best effort: they're turned away whether or not it gets there.
+		(void) send(fd, full, len, MSG_DONTWAIT);
+		close(fd);
+		return;
+	}
+
+	clients = realloc(sv->clients, (sv->nclients + 1) * sizeof(*clients));
+	c = calloc(1, sizeof(*c));
+	if (clients)
+		sv->clients = clients;
+	if (!clients || !c || set_nonblocking(fd)) {
+		free(c);
+		close(fd);
+		return;
+	}
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	c->src.fd = fd;
+	c->src.kind = SOURCE_CLIENT;
+	c->sv = sv;
+	c->ss.hooks = &client_hooks;
+	c->ss.ctx = c;
+	c->ss.profile = sv->cfg->profile;
+	c->ss.smooth = sv->cfg->smooth;
+	c->ss.scores = sv->cfg->scores;
+	if (!inet_ntop(AF_INET, &addr.sin_addr, c->name, sizeof(c->name)))
+		strcpy(c->name, "anonymous");
+	if (session_start(&c->ss, NUM_ROWS, NUM_COLS, sv->next_seed++) ||
+			ansi_resize(&c->r, NUM_ROWS, NUM_COLS) ||
+			watch(sv, &c->src, EPOLLIN)) {
+		client_free(c);
+		return;
+	}
+	if (sv->cfg->scores)
+		sim_set_best(&c->ss.s, scores_best(sv->cfg->scores, c->name));
+
+	c->index = sv->nclients;
+	sv->clients[sv->nclients++] = c;
+	if (send_text(c, TELNET_HELLO, sizeof(TELNET_HELLO) - 1) ||
+			send_text(c, ANSI_HELLO, sizeof(ANSI_HELLO) - 1))
+		c->gone = 1;
+}
+
+/**
+ * Handles the end of a telnet subnegotiation; only window sizes matter.
+ */
+static void end_subnegotiation(client *c) {
+	if (c->sb_len >= 5 && c->sb[0] == OPT_NAWS) {
+		int cols = c->sb[1] << 8 | c->sb[2];
+		int rows = c->sb[3] << 8 | c->sb[4];
+		if (rows > 0 && cols > 0 && rows <= 1000 && cols <= 1000) {
+			c->new_rows = rows;
+			c->new_cols = cols;
+			input_add(&c->in, TERM_KEY_RESIZE);
+		}
+	}
+}
+
+/**
+ * Feeds a byte from the client's terminal through the telnet and escape
+ * sequence parsers, queueing any key it completes.
+ */
+static void parse_input(client *c, unsigned char byte) {
+	int key;
+
+	switch (c->telnet) {
+	case TELNET_DATA:
+		if (byte == IAC) {
+			c->telnet = TELNET_IAC;
+			return;
+		}
+		break;
+	case TELNET_IAC:
+		if (byte == IAC) { // An escaped 255 data byte.
+			c->telnet = TELNET_DATA;
+			break;
+		}
+		c->sb_len = 0;
+		c->telnet = byte == SB ? TELNET_SB :
+				byte >= 251 ? TELNET_OPTION : TELNET_DATA;
+		return;
+	case TELNET_OPTION:
+		c->telnet = TELNET_DATA;
+		return;
+	case TELNET_SB:
+		if (byte == IAC)
+			c->telnet = TELNET_SB_IAC;
+		else if (c->sb_len < (int) sizeof(c->sb))
+			c->sb[c->sb_len++] = byte;
+		return;
+	case TELNET_SB_IAC:
+		if (byte == SE) {
+			end_subnegotiation(c);
+			c->telnet = TELNET_DATA;
+		}
+		else {
+			if (c->sb_len < (int) sizeof(c->sb))
+				c->sb[c->sb_len++] = byte;
+			c->telnet = TELNET_SB;
+		}
+		return;
+	}
+
+	// A data byte, but for the NUL telnet sends after a carriage return.
+	if (byte != 0 && (key = key_decode(&c->keys, byte)) != TERM_NO_KEY)
+		input_add(&c->in, key);
+}
+
+/**
+ * Reads whatever the client sent.
+ *
+ * @return 0 on success, -1 if the client hung up.
+ */
+static int read_client(client *c) {
+	unsigned char buf[512];
+	ssize_t n, i;
+	int key;
+
+	for (;;) {
+		n = read(c->src.fd, buf, sizeof(buf));
+		if (n == 0)
+			return -1;
+		if (n < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ?
+					0 : -1;
+		for (i = 0; i < n; i++)
+			parse_input(c, buf[i]);
+		if ((key = key_decode_end(&c->keys)) != TERM_NO_KEY)
+			input_add(&c->in, key);
+	}
+}
+
+/**
+ * Advances a client's session by the ticks that came due, with every key
+ * that came in since the last tick, and sends them their next frame.
+ */
+static void client_tick(client *c, int ticks) {
+	term_input in = c->in;
+
+	memset(&c->in, 0, sizeof(c->in));
+
+	// A terminal the server can't keep up with is a player who has to go.
+	if (in.resized) {
+		if (client_fit(c, c->new_rows, c->new_cols))
+			in.quit = 1;
+	}
+	session_tick(&c->ss, &in, ticks);
+}
+
+/**
+ * Every SCORE_FLUSH_TICKS, writes the scores of the games that ended since
+ * the last time, and picks up what other servers and games wrote. A failed
+ * write is retried next time, and so is one while somebody else is writing
+ * the file: the server never waits for the lock with players to tick.
+ */
+static void tick_scores(server *sv, int ticks) {
+	score_store *st = sv->cfg->scores;
+
+	if (!st || (sv->score_ticks += ticks) < SCORE_FLUSH_TICKS)
+		return;
+	sv->score_ticks = 0;
+	if (st->npending > 0)
+		scores_try_flush(st);
+	else
+		scores_refresh(st);
+}
+
+/**
+ * Ticks every game and sends every player their next frame.
+ */
+static void tick_all(server *sv, int ticks) {
+	int i;
+
+	for (i = 0; i < sv->nclients; i++) {
+		client *c = sv->clients[i];
+
+		if (c->gone)
+			continue;
+
+		// A leaving player's connection stays up until their terminal has
+		// been reset, or for LINGER_TICKS at most.
+		if (c->ss.mode == MODE_QUIT) {
+			if (send_pending(c) || c->pending.len == 0 ||
+					(c->ss.mode_ticks += ticks) > LINGER_TICKS)
+				c->gone = 1;
+			continue;
+		}
+
+		client_tick(c, ticks);
+		if (c->ss.mode == MODE_QUIT && (c->gone ||
+				send_text(c, ANSI_BYE, sizeof(ANSI_BYE) - 1) ||
+				c->pending.len == 0))
+			c->gone = 1;
+	}
+	tick_scores(sv, ticks);
+}
+
+/**
+ * Opens the listening socket, the tick timer and the shutdown signals.
+ *
+ * @return 0 on success, -1 with errno set on error.
+ */
+static int server_open(server *sv) {
+	struct sockaddr_in addr;
+	struct itimerspec period;
+	sigset_t mask;
+	int one = 1;
+
+	sv->epfd = epoll_create1(EPOLL_CLOEXEC);
+	sv->listener.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	sv->timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+	sv->signals.fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (sv->epfd < 0 || sv->listener.fd < 0 || sv->timer.fd < 0 ||
+			sv->signals.fd < 0)
+		return -1;
+	sv->listener.kind = SOURCE_LISTENER;
+	sv->timer.kind = SOURCE_TIMER;
+	sv->signals.kind = SOURCE_SIGNALS;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(sv->cfg->port);
+	setsockopt(sv->listener.fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (bind(sv->listener.fd, (struct sockaddr *) &addr, sizeof(addr)) ||
+			listen(sv->listener.fd, 128) || set_nonblocking(sv->listener.fd))
+		return -1;
+
+	period.it_interval.tv_sec = 0;
+	period.it_interval.tv_nsec = 1000000000L / SESSION_FPS;
+	period.it_value = period.it_interval;
+	if (timerfd_settime(sv->timer.fd, 0, &period, NULL))
+		return -1;
+
+	return watch(sv, &sv->listener, EPOLLIN) ||
+			watch(sv, &sv->timer, EPOLLIN) ||
+			watch(sv, &sv->signals, EPOLLIN) ? -1 : 0;
+}
+
+/**
+ * Says goodbye to every player, waiting up to LINGER_MS in all for the
+ * output still pending to go out, so that no terminal is left as the game
+ * had it.
+ */
+static void linger_all(server *sv) {
+	struct pollfd *fds = calloc(sv->nclients ? sv->nclients : 1, sizeof(*fds));
+	struct timespec start, now;
+	int i, n, left = LINGER_MS;
+
+	for (i = 0; i < sv->nclients; i++) {
+		client *c = sv->clients[i];
+		if (!c->gone && c->ss.mode != MODE_QUIT &&
+				send_text(c, ANSI_BYE, sizeof(ANSI_BYE) - 1))
+			c->gone = 1;
+	}
+	if (!fds)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (left > 0) {
+		for (i = n = 0; i < sv->nclients; i++) {
+			client *c = sv->clients[i];
+			if (c->gone || c->pending.len == 0)
+				continue;
+			fds[n].fd = c->src.fd;
+			fds[n].events = POLLOUT;
+			n++;
+		}
+		if (n == 0 || poll(fds, n, left) < 0)
+			break;
+		for (i = 0; i < sv->nclients; i++)
+			if (!sv->clients[i]->gone && send_pending(sv->clients[i]))
+				sv->clients[i]->gone = 1;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		left = LINGER_MS - ((now.tv_sec - start.tv_sec) * 1000 +
+				(now.tv_nsec - start.tv_nsec) / 1000000);
+	}
+	free(fds);
+}
+
+static void server_close(server *sv) {
+	linger_all(sv);
+	while (sv->nclients > 0)
+		drop_client(sv, sv->clients[0]);
+	free(sv->clients);
+	close(sv->listener.fd);
+	close(sv->timer.fd);
+	close(sv->signals.fd);
+	close(sv->epfd);
+}
+
+/**
+ * Serves games until SIGINT or SIGTERM.
+ *
+ * @param cfg Where to listen and how many players to take.
+ *
+ * @return 0 after a clean shutdown, -1 with errno set if the server
+ * couldn't be started.
+ */
+int server_run(const server_config *cfg) {
+	struct epoll_event events[64];
+	server sv;
+	uint64_t expirations;
+	int i, n, running = 1, status = 0;
+
+	memset(&sv, 0, sizeof(sv));
+	sv.cfg = cfg;
+	sv.next_seed = cfg->seed;
+	sv.epfd = sv.listener.fd = sv.timer.fd = sv.signals.fd = -1;
+	signal(SIGPIPE, SIG_IGN); // Broken connections show up as EPIPE.
+
+	if (server_open(&sv)) {
+		int saved = errno;
+		server_close(&sv);
+		errno = saved;
+		return -1;
+	}
+
+	while (running) {
+		n = epoll_wait(sv.epfd, events, 64, -1);
+		if (n < 0 && errno != EINTR) {
+			status = -1;
+			break;
+		}
+
+		for (i = 0; i < n; i++) {
+			source *src = events[i].data.ptr;
+
+			switch (src->kind) {
+			case SOURCE_LISTENER:
+				accept_client(&sv);
+				break;
+			case SOURCE_TIMER:
+				if (read(src->fd, &expirations, sizeof(expirations)) ==
+						sizeof(expirations))
+					tick_all(&sv, expirations < (uint64_t) SERVER_MAX_CATCHUP ?
+							(int) expirations : SERVER_MAX_CATCHUP);
+				break;
+			case SOURCE_SIGNALS:
+				running = 0;
+				break;
+			case SOURCE_CLIENT:
+				if ((events[i].events & (EPOLLERR | EPOLLHUP)) ||
+						read_client((client *) src))
+					((client *) src)->gone = 1;
+				break;
+			}
+		}
+		reap_clients(&sv);
+	}
+
+	server_close(&sv);
+	return status;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file
+ *
+ * Multi-session game server, for --serve. One process holds the games of
+ * every connected player and ticks them all from a single timer; sockets,
+ * the timer and signals are all multiplexed with epoll. Each game is drawn
+ * with the diffing ANSI emitter into the connection's own buffer, so a
+ * connection costs a game_state, two cellbufs and a few dozen bytes of
+ * output per frame, and no process or ncurses screen of its own.
+ *
+ * Players connect with telnet, which the server switches to character at a
+ * time mode and asks for the window size, or with anything else that pipes
+ * a terminal to a socket (e.g. nc after stty raw, or ssh -t host nc ...).
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "profile.h"
+#include "scores.h"
+
+/** Settings for the server. */
+typedef struct server_config {
+	/* TCP port to listen on. */
+	int port;
+
+	/* Most players at once; more are turned away. */
+	int max_clients;
+
+	/* Seed of the first player's games; each player gets the next one. */
+	unsigned int seed;
+
+	/*
+	 * Where players' scores go, under their address, or NULL. Scores are
+	 * written every few seconds while games end, not on every game over.
+	 */
+	score_store *scores;
+
+	/* Difficulty profile of every game, or NULL for the classic game. */
+	const profile *profile;
+
+	/*
+	 * Nonzero to draw Flappy to half a row with block glyphs, which takes
+	 * players' terminals to be in UTF-8.
+	 */
+	int smooth;
+} server_config;
+
+int server_run(const server_config *cfg);
+
+#endif
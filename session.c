@@ -0,0 +1,322 @@
+/**
+ * @file
+ *
+ * Player sessions and key decoding, for the interactive game and the
+ * server alike. See session.h.
+ */
+
+#include <time.h>
+
+#include "session.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** How far through the escape sequence of a special key a decoder is. */
+enum key_state {
+	KEY_TEXT,       // Between keys.
+	KEY_ESC,        // After ESC.
+	KEY_SEQUENCE    // After ESC [ or ESC O, in the parameters.
+};
+
+//------------------------------ Global Constants -----------------------------
+
+/** Amount of time the splash screen's progress bar takes to fill up. */
+static const float START_TIME_SEC = 3;
+
+/** Amount of time the full progress bar stays up before the game starts. */
+static const float SPLASH_HOLD_SEC = 0.5;
+
+/** How long the game over screen stays up when the autopilot plays. */
+static const float AUTOPLAY_RESTART_SEC = 1;
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Lays the screen out for a terminal size and resizes the frame to match,
+ * and the game too if it's to be resized.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+static int fit(session *ss, int rows, int cols, int resize_game) {
+	layout_compute(&ss->l, rows, cols);
+	ss->l.smooth = ss->smooth;
+	if (cellbuf_resize(&ss->frame, rows, cols))
+		return -1;
+
+	ss->too_small = rows < MIN_ROWS || cols < MIN_COLS;
+	if (resize_game && !ss->too_small)
+		sim_resize(&ss->s, rows, cols);
+	return 0;
+}
+
+/**
+ * Starts a session on the splash screen. Set the hooks and whatever else
+ * the front end plugs in before calling this.
+ *
+ * @param ss Session to start.
+ * @param rows, cols Size of the player's terminal.
+ * @param seed Seed of the first game.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int session_start(session *ss, int rows, int cols, unsigned int seed) {
+	ss->mode = MODE_SPLASH;
+	ss->mode_ticks = 0;
+	ss->idle = 0;
+
+	sim_init(&ss->s, rows < MIN_ROWS ? MIN_ROWS : rows,
+			cols < MIN_COLS ? MIN_COLS : cols, seed);
+	if (ss->profile)
+		sim_set_profile(&ss->s, ss->profile);
+	if (fit(ss, rows, cols, 0))
+		return -1;
+	if (ss->recorder)
+		replay_begin(ss->recorder, &ss->s);
+	return 0;
+}
+
+/**
+ * Fits a session to a new size of the player's terminal. Nothing is
+ * re-derived per frame, so call this only when the size changes.
+ *
+ * @return 0 on success, -1 if out of memory.
+ */
+int session_resize(session *ss, int rows, int cols) {
+	if (fit(ss, rows, cols, 1))
+		return -1;
+	if (ss->recorder && ss->mode != MODE_GAME_OVER)
+		replay_mark(ss->recorder, REPLAY_RESIZED);
+	return 0;
+}
+
+/**
+ * Switches a session to another mode.
+ */
+static void set_mode(session *ss, enum session_mode mode) {
+	ss->mode = mode;
+	ss->mode_ticks = 0;
+}
+
+/**
+ * Advances the splash screen, whose progress bar fills up over
+ * START_TIME_SEC and then stays full for SPLASH_HOLD_SEC.
+ */
+static void splash_tick(session *ss, int ticks) {
+	int fill = START_TIME_SEC * SESSION_FPS;
+	int len;
+
+	ss->mode_ticks += ticks;
+	if (ss->mode_ticks >= fill + SPLASH_HOLD_SEC * SESSION_FPS) {
+		set_mode(ss, MODE_PLAYING);
+		return;
+	}
+
+	len = ss->mode_ticks >= fill ? ss->l.prog_bar_len :
+			ss->l.prog_bar_len * ss->mode_ticks / fill;
+	draw_splash(&ss->frame, &ss->l);
+	draw_progress(&ss->frame, &ss->l, len);
+	ss->hooks->show(ss);
+}
+
+/**
+ * Advances the game by the ticks that came due and draws the last of them.
+ */
+static void play_tick(session *ss, const term_input *in, int ticks) {
+	game_state *s = &ss->s;
+
+	// Give Flappy a boost! Any number of presses since the last tick make
+	// one flap, which belongs to the first tick due only.
+	int input = in->flaps > 0 ? INPUT_FLAP : INPUT_NONE;
+
+	// Update pipe locations and Flappy.
+	while (ticks-- > 0 && !s->dead) {
+		if (ss->pilot)
+			input = autopilot_decide(ss->pilot, s);
+		sim_step(s, input);
+		if (ss->recorder)
+			replay_frame(ss->recorder, input);
+		input = INPUT_NONE;
+	}
+	if (ss->stats)
+		stats_lap(ss->stats, PHASE_SIM);
+
+	if (s->dead) {
+		if (ss->recorder)
+			replay_end(ss->recorder, s);
+		if (ss->hooks->game_over)
+			ss->hooks->game_over(ss);
+		set_mode(ss, MODE_GAME_OVER);
+		return;
+	}
+
+	// Compose the frame off-screen and send only what changed.
+	draw_game(&ss->frame, &ss->l, s);
+	if (ss->stats) {
+		char status[64];
+		stats_format(ss->stats, status, sizeof(status));
+		draw_status(&ss->frame, &ss->l, status);
+		stats_lap(ss->stats, PHASE_DRAW);
+	}
+	ss->hooks->show(ss);
+	if (ss->stats) {
+		stats_lap(ss->stats, PHASE_OUTPUT);
+		stats_end(ss->stats, s->frame);
+	}
+}
+
+/**
+ * Shows the game over message until the player presses a key to play
+ * again. Nothing moves meanwhile, so the session goes idle, unless the
+ * autopilot is playing: then the next game starts by itself after
+ * AUTOPLAY_RESTART_SEC.
+ */
+static void game_over_tick(session *ss, const term_input *in, int ticks) {
+	ss->mode_ticks += ticks;
+	if (in->flaps > 0 || in->other || (ss->pilot &&
+			ss->mode_ticks >= AUTOPLAY_RESTART_SEC * SESSION_FPS)) {
+		sim_restart(&ss->s);
+		if (ss->recorder)
+			replay_begin(ss->recorder, &ss->s);
+		set_mode(ss, MODE_PLAYING);
+		return;
+	}
+
+	draw_failure(&ss->frame, &ss->l);
+	if (ss->scores)
+		draw_leaderboard(&ss->frame, &ss->l, ss->scores->records,
+				ss->scores->nrecords);
+	ss->hooks->show(ss);
+	ss->idle = !ss->pilot;
+}
+
+/**
+ * Handles one tick of a session: every key pressed since the last tick, and
+ * the ticks of the game that came due since the last call. Never blocks.
+ * All the keys are handled at once, so a burst of key presses is handled in
+ * one frame rather than one key per frame. A change of terminal size is up
+ * to the front end, with session_resize() before the tick.
+ *
+ * @param ss Session to advance.
+ * @param in Keys pressed since the last call.
+ * @param ticks Number of ticks that came due; 0 to only handle the keys.
+ */
+void session_tick(session *ss, const term_input *in, int ticks) {
+	if (ss->stats) {
+		stats_begin(ss->stats);
+		if (in->keys > 0)
+			stats_key(ss->stats, &in->first);
+	}
+	ss->idle = 0;
+
+	if (in->quit) {
+		if (ss->recorder && ss->mode == MODE_PLAYING)
+			replay_end(ss->recorder, &ss->s);
+		set_mode(ss, MODE_QUIT);
+		return;
+	}
+	if (ss->stats)
+		stats_lap(ss->stats, PHASE_INPUT);
+
+	// Hold everything until the terminal is big enough again.
+	if (ss->too_small) {
+		draw_too_small(&ss->frame, &ss->l);
+		ss->hooks->show(ss);
+		ss->idle = 1;
+		return;
+	}
+
+	switch (ss->mode) {
+	case MODE_SPLASH:
+		splash_tick(ss, ticks);
+		break;
+	case MODE_PLAYING:
+		play_tick(ss, in, ticks);
+		break;
+	case MODE_GAME_OVER:
+		game_over_tick(ss, in, ticks);
+		break;
+	case MODE_QUIT:
+		break;
+	}
+}
+
+/**
+ * Releases what a session allocated.
+ */
+void session_free(session *ss) {
+	cellbuf_free(&ss->frame);
+}
+
+/**
+ * Adds a key to what was pressed since the last tick, boiling it down to
+ * what the game uses.
+ *
+ * @param in What was pressed.
+ * @param key A character or one of the term_key keys.
+ */
+void input_add(term_input *in, int key) {
+	if (in->keys++ == 0)
+		clock_gettime(CLOCK_MONOTONIC, &in->first);
+	switch (key) {
+	case 'q':
+		in->quit = 1;
+		break;
+	case TERM_KEY_UP:
+		in->flaps++;
+		break;
+	case TERM_KEY_RESIZE:
+		in->resized = 1;
+		break;
+	default:
+		in->other = 1;
+		break;
+	}
+}
+
+/**
+ * Decodes the bytes a terminal sends into keys, one byte at a time. The
+ * escape sequences of the up arrow, ESC [ A or ESC O A in application
+ * mode, become TERM_KEY_UP and those of other special keys TERM_KEY_OTHER;
+ * ESC and then a key is that key with Alt held down, which is
+ * TERM_KEY_OTHER too.
+ *
+ * @param d Decoder state, kept from one byte to the next.
+ * @param byte Next byte from the terminal.
+ *
+ * @return The key the byte completed, or TERM_NO_KEY.
+ */
+int key_decode(key_decoder *d, unsigned char byte) {
+	switch (d->state) {
+	case KEY_ESC:
+		if (byte == '[' || byte == 'O') {
+			d->state = KEY_SEQUENCE;
+			return TERM_NO_KEY;
+		}
+		d->state = KEY_TEXT;
+		return TERM_KEY_OTHER;
+	case KEY_SEQUENCE:
+		if ((byte >= '0' && byte <= '9') || byte == ';')
+			return TERM_NO_KEY;
+		d->state = KEY_TEXT;
+		return byte == 'A' ? TERM_KEY_UP : TERM_KEY_OTHER;
+	default:
+		if (byte == 27) {
+			d->state = KEY_ESC;
+			return TERM_NO_KEY;
+		}
+		return byte;
+	}
+}
+
+/**
+ * Tells a decoder that the bytes read in one go ran out. An escape
+ * sequence arrives in one read, so an ESC left hanging is just ESC.
+ *
+ * @return The key that was left hanging, or TERM_NO_KEY.
+ */
+int key_decode_end(key_decoder *d) {
+	if (d->state != KEY_ESC)
+		return TERM_NO_KEY;
+	d->state = KEY_TEXT;
+	return 27;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file
+ *
+ * One player's time with the game, from the splash screen until they quit,
+ * and the keys they press. The interactive game (driver.c) and the server
+ * (server.c) both run their players through here, so the modes, the splash
+ * timing and what every key does are the same on a terminal and over the
+ * network. What differs between them, e.g. how a frame gets onto the
+ * player's terminal or where a score goes, is left to session_hooks.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "autopilot.h"
+#include "backend.h"
+#include "cellbuf.h"
+#include "draw.h"
+#include "profile.h"
+#include "replay.h"
+#include "scores.h"
+#include "sim.h"
+#include "stats.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** Ticks per second of every session. */
+#define SESSION_FPS 24
+
+/** What a session is doing. */
+enum session_mode {
+	MODE_SPLASH,     // Showing the title and progress bar.
+	MODE_PLAYING,
+	MODE_GAME_OVER,  // Waiting for the player to play again or quit.
+	MODE_QUIT        // The player quit.
+};
+
+typedef struct session session;
+
+/** What the front end running a session does for it. */
+typedef struct session_hooks {
+	/* Gets the session's frame onto the player's terminal. */
+	void (*show)(session *ss);
+
+	/* Keeps the score of the game that just ended, or NULL. */
+	void (*game_over)(session *ss);
+} session_hooks;
+
+/**
+ * One player's session. A session never blocks: session_tick() handles one
+ * tick's worth of input and drawing and returns, so whatever runs the ticks
+ * is free to do other work in between.
+ */
+struct session {
+	enum session_mode mode;
+
+	/* Ticks spent in the current mode. */
+	int mode_ticks;
+
+	/*
+	 * Nonzero if what's on the screen stays the same until a key is
+	 * pressed, so the session needs no ticks until then.
+	 */
+	int idle;
+
+	game_state s;
+
+	/* Where things go on the player's terminal, and the frame to show. */
+	layout l;
+	cellbuf frame;
+
+	/* Nonzero if the terminal is too small to play in. */
+	int too_small;
+
+	/*
+	 * Set by the front end before session_start(). Everything but 'hooks'
+	 * may be left NULL or 0.
+	 */
+	const session_hooks *hooks;
+
+	/* The front end's own data about the player. */
+	void *ctx;
+
+	/* Difficulty profile of every game; see layout.smooth for 'smooth'. */
+	const profile *profile;
+	int smooth;
+
+	/* Records every game played. */
+	replay_writer *recorder;
+
+	/* Times every frame. */
+	frame_stats *stats;
+
+	/* Plays instead of the player, game after game, until they quit. */
+	autopilot *pilot;
+
+	/* High scores shown on the game over screen. */
+	const score_store *scores;
+};
+
+/**
+ * Where a key_decode() is in the escape sequence of a special key. Clear it
+ * to all zeros before the first byte.
+ */
+typedef struct key_decoder {
+	int state;
+} key_decoder;
+
+//---------------------------------- Functions --------------------------------
+
+int session_start(session *ss, int rows, int cols, unsigned int seed);
+int session_resize(session *ss, int rows, int cols);
+void session_tick(session *ss, const term_input *in, int ticks);
+void session_free(session *ss);
+void input_add(term_input *in, int key);
+int key_decode(key_decoder *d, unsigned char byte);
+int key_decode_end(key_decoder *d);
+
+#endif
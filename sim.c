@@ -0,0 +1,515 @@
+/**
+ * @file
+ *
+ * Headless Flappy Bird engine: pipe movement, Flappy's parabola, collisions
+ * and scoring. See sim.h.
+ */
+
+#include <stddef.h>
+
+#include "profile.h"
+#include "sim.h"
+
+//------------------------------ Global Constants -----------------------------
+
+#ifndef FLAP_FAST
+const int ROW_SCALE = SIM_ROW_SCALE;
+
+const int GRAV = SIM_GRAV;
+
+const int V0 = SIM_V0;
+
+const int NUM_ROWS = SIM_NUM_ROWS;
+
+const int NUM_COLS = SIM_NUM_COLS;
+
+const int PIPE_RADIUS = SIM_PIPE_RADIUS;
+
+const int OPENING_WIDTH = SIM_OPENING_WIDTH;
+
+const int FLAPPY_COL = SIM_FLAPPY_COL;
+
+const int PIPE_SPACING = SIM_PIPE_SPACING;
+#endif
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Sets up a random number generator for sim_rand(). Any seed works, zero
+ * included; it is scrambled with splitmix64 first so that nearby seeds,
+ * like those of consecutive batch episodes, give unrelated sequences.
+ *
+ * @param[out] rng Generator state to set up.
+ * @param seed
+ */
+void sim_seed_rng(uint64_t *rng, uint64_t seed) {
+	uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+
+	// xorshift gets stuck on zero.
+	*rng = z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * Gets a random fraction in [0, 1).
+ */
+static float random_fraction(uint64_t *rng) {
+	// 24 random bits convert to a float exactly.
+	return (sim_rand(rng) >> 8) / 16777216.0f;
+}
+
+/**
+ * Gets a random opening height fraction for a pipe, in [0.25, 0.75).
+ *
+ * @param rng State of the random number generator to draw from.
+ */
+float random_opening_height(uint64_t *rng) {
+	return random_fraction(rng) * 0.5f + 0.25f;
+}
+
+/**
+ * Gets the smallest spacing that keeps pipes from overlapping and the pool
+ * from running out of pipes on the given board.
+ */
+static int min_spacing(const game_state *s) {
+	int span = s->cols + 2 * PIPE_RADIUS + 1;
+	int spacing = (span + MAX_PIPES - 1) / MAX_PIPES;
+	return spacing > 2 * PIPE_RADIUS + 2 ? spacing : 2 * PIPE_RADIUS + 2;
+}
+
+/**
+ * Gets the number of pipes it takes to keep one every 'spacing' columns
+ * across the screen and the stretch off the left and right edges where they
+ * wrap around.
+ */
+static int pipes_needed(const game_state *s) {
+	return (s->cols + 2 * PIPE_RADIUS + 1 + s->pipes.spacing - 1) /
+			s->pipes.spacing;
+}
+
+/**
+ * Gives a new pipe a random opening, as tall as the profile says for the
+ * current score.
+ */
+static void new_opening(game_state *s, vpipe *p) {
+	if (s->profile) {
+		const profile_level *lv = profile_at(s->profile, s->score);
+		p->opening_width = lv->opening_width;
+		p->opening_height = random_fraction(&s->rng) * lv->opening_range +
+				lv->opening_low;
+	}
+	else {
+		p->opening_width = OPENING_WIDTH;
+		p->opening_height = random_opening_height(&s->rng);
+	}
+	pipe_shape(p, s->rows);
+}
+
+/**
+ * Switches to the profile's spacing and scroll for the current score.
+ */
+static void apply_level(game_state *s) {
+	const profile_level *lv = profile_at(s->profile, s->score);
+
+	s->pipes.spacing = lv->spacing < min_spacing(s) ?
+			min_spacing(s) : lv->spacing;
+	s->pipes.scroll = lv->scroll;
+}
+
+/**
+ * Adds a pipe to the right end of the pool, one spacing behind the previous
+ * one but never closer than just out of view.
+ */
+static vpipe *append_pipe(game_state *s) {
+	pipe_pool *pool = &s->pipes;
+	vpipe *p = &POOL_PIPE(pool, pool->count);
+
+	p->center = pool->count ?
+			POOL_PIPE(pool, pool->count - 1).center + pool->spacing : 0;
+	if (p->center < s->cols + PIPE_RADIUS)
+		p->center = s->cols + PIPE_RADIUS;
+	new_opening(s, p);
+	pool->count++;
+	return p;
+}
+
+/**
+ * Fits the pool to a new spacing in the middle of a round: adds pipes on the
+ * right while there are too few to keep one every 'spacing' columns, and
+ * drops the rightmost ones while there are too many and they are still out
+ * of view. Pipes on screen are left where they are.
+ */
+static void fit_pool(game_state *s) {
+	pipe_pool *pool = &s->pipes;
+	int n = pipes_needed(s);
+
+	while (pool->count < n)
+		append_pipe(s);
+	while (pool->count > n &&
+			POOL_PIPE(pool, pool->count - 1).center - PIPE_RADIUS >= s->cols)
+		pool->count--;
+}
+
+/**
+ * Lines the pipes up just out of view on the right, with the first one
+ * 20% of a screen width past the right edge.
+ */
+static void reset_pipes(game_state *s) {
+	pipe_pool *pool = &s->pipes;
+	int i, n = pipes_needed(s);
+
+	pool->head = 0;
+	for (i = 0; i < n; i++) {
+		vpipe *p = &POOL_PIPE(pool, i);
+		p->center = (int)(1.2 * (s->cols - 1)) + i * pool->spacing;
+		new_opening(s, p);
+	}
+	pool->count = n;
+}
+
+/**
+ * Puts the pipes just out of view on the right and Flappy in the middle of
+ * the screen. Scores are left alone. The random numbers start over from the
+ * round's seed, so a round is completely described by its seed, its board
+ * and its inputs.
+ */
+static void start_round(game_state *s) {
+	sim_seed_rng(&s->rng, s->seed);
+	if (s->profile)
+		apply_level(s);
+	reset_pipes(s);
+
+	s->bird.y = s->rows / 2 * ROW_SCALE;
+	s->bird.v = V0;
+	s->dead = 0;
+}
+
+/**
+ * Starts the very first game.
+ *
+ * @param[out] s Game to initialize.
+ * @param rows Height of the board, including the floor and ceiling.
+ * @param cols Width of the board.
+ * @param seed Seed for the game's random numbers. The same seed and the
+ * same inputs always play out the same way.
+ */
+void sim_init(game_state *s, int rows, int cols, unsigned int seed) {
+	s->seed = seed;
+	s->rows = rows;
+	s->cols = cols;
+	s->frame = 0;
+	s->score = 0;
+	s->sdigs = 1;
+	s->best_score = 0;
+	s->bdigs = 1;
+	s->pipes.spacing = PIPE_SPACING;
+	s->pipes.scroll = 1;
+	if (s->pipes.spacing < min_spacing(s))
+		s->pipes.spacing = min_spacing(s);
+	s->profile = NULL;
+	start_round(s);
+}
+
+/**
+ * Sets the best score shown, e.g. to one from an earlier run.
+ *
+ * @param s Game to update.
+ * @param best The best score.
+ */
+void sim_set_best(game_state *s, int best) {
+	s->best_score = best;
+	s->bdigs = best > 99 ? 3 : best > 9 ? 2 : 1;
+}
+
+/**
+ * Starts a new game after Flappy died, keeping track of the best score.
+ *
+ * @param s Game to restart.
+ */
+void sim_restart(game_state *s) {
+	if (s->score > s->best_score)
+		sim_set_best(s, s->score);
+	s->score = 0;
+	s->sdigs = 1;
+
+	// The next round's seed comes from this round's random numbers.
+	s->seed = sim_rand(&s->rng);
+	start_round(s);
+}
+
+/**
+ * Changes the distance between neighboring pipes, e.g. for a denser
+ * variant of the game, and starts a new round with the new spacing. The
+ * spacing is clamped so that pipes never overlap and the pool never runs
+ * out of pipes.
+ *
+ * @param s Game to change.
+ * @param spacing Columns between the centers of neighboring pipes.
+ */
+void sim_set_spacing(game_state *s, int spacing) {
+	s->pipes.spacing = spacing < min_spacing(s) ? min_spacing(s) : spacing;
+	start_round(s);
+}
+
+/**
+ * Changes how fast the pipes come at Flappy, e.g. for a harder variant of
+ * the game or to fast-forward through a game in fewer frames. Collisions
+ * are swept over the whole move (see swept_crash()), so pipes can't jump
+ * past Flappy however fast they go.
+ *
+ * @param s Game to change.
+ * @param scroll Columns the pipes move left every frame, at least 1.
+ */
+void sim_set_scroll(game_state *s, int scroll) {
+	s->pipes.scroll = scroll < 1 ? 1 : scroll;
+}
+
+/**
+ * Makes the game follow a difficulty profile, from a new round on: the
+ * openings, spacing and speed of the pipes then depend on the score, as
+ * looked up in the profile whenever a pipe appears or the score changes.
+ * The profile overrides sim_set_spacing() and sim_set_scroll(), and must
+ * outlive the game.
+ *
+ * @param s Game to change.
+ * @param p Profile to follow, or NULL to go back to the classic game.
+ */
+void sim_set_profile(game_state *s, const profile *p) {
+	s->profile = p;
+	if (!p) {
+		s->pipes.spacing = PIPE_SPACING < min_spacing(s) ?
+				min_spacing(s) : PIPE_SPACING;
+		s->pipes.scroll = 1;
+	}
+	start_round(s);
+}
+
+/**
+ * Fits a game in progress to a new board size. Pipe openings keep their
+ * height as a fraction of the board, Flappy keeps his relative height, and
+ * pipes are added or dropped on the right so the pool still covers the
+ * board.
+ *
+ * @param s Game to change.
+ * @param rows New height of the board, including the floor and ceiling.
+ * @param cols New width of the board.
+ */
+void sim_resize(game_state *s, int rows, int cols) {
+	pipe_pool *pool = &s->pipes;
+	int i, n;
+
+	s->bird.y = (int64_t) s->bird.y * rows / s->rows;
+	s->rows = rows;
+	s->cols = cols;
+	if (pool->spacing < min_spacing(s))
+		pool->spacing = min_spacing(s);
+
+	for (i = 0; i < pool->count; i++)
+		pipe_shape(&POOL_PIPE(pool, i), rows);
+
+	n = pipes_needed(s);
+	if (pool->count > n)
+		pool->count = n;
+	while (pool->count < n)
+		append_pipe(s);
+}
+
+/**
+ * Advances the game by one frame. Does nothing once Flappy is dead; call
+ * sim_restart() to play again.
+ *
+ * @param s Game to advance.
+ * @param input INPUT_FLAP to give Flappy a boost, INPUT_NONE otherwise.
+ */
+void sim_step(game_state *s, int input) {
+	int h, y0 = s->bird.y;
+
+	if (s->dead)
+		return;
+
+	flappy_move(&s->bird, input);
+	pipe_refresh(s);
+
+	// Flappy crashed into the ceiling, the floor or a pipe.
+	h = get_flappy_position(s->bird);
+	if (h <= 0 || h >= s->rows - 1 || (s->pipes.scroll == 1 ?
+			crashed_into_pipes(h, &s->pipes, 0) :
+			swept_crash(s->bird, y0, &s->pipes))) {
+		s->dead = 1;
+		return;
+	}
+
+	s->frame++;
+}
+
+/**
+ * Updates the pipe centers and opening heights for each new frame. If the
+ * leftmost pipe is sufficiently far off-screen to the left its slot is
+ * recycled as the rightmost pipe, at which time the opening height is
+ * changed. Under a profile the score then picks the spacing, and the pool
+ * grows or shrinks to match it.
+ */
+void pipe_refresh(game_state *s) {
+	pipe_pool *pool = &s->pipes;
+	int i;
+
+	// If pipe exits screen on the left then wrap it to the right side of the
+	// screen.
+	while (POOL_PIPE(pool, 0).center + PIPE_RADIUS < 0) {
+		pool->count--;
+		pool->head = (pool->head + 1) & (MAX_PIPES - 1);
+		append_pipe(s);
+		s->score++;
+		if(s->sdigs == 1 && s->score > 9)
+			s->sdigs++;
+		else if(s->sdigs == 2 && s->score > 99)
+			s->sdigs++;
+		if (s->profile) {
+			apply_level(s);
+			fit_pool(s);
+		}
+	}
+
+	for (i = 0; i < pool->count; i++)
+		POOL_PIPE(pool, i).center -= pool->scroll;
+}
+
+/**
+ * Recomputes the cached rows of a pipe's opening and lips. Call this after
+ * changing the opening height or the number of rows on the board.
+ */
+void pipe_shape(vpipe *p, int rows) {
+	p->top_orow = get_orow(*p, 1, rows);
+	p->bottom_orow = get_orow(*p, 0, rows);
+
+	// The lips sit on the opening, but never on the ceiling or floor.
+	p->upper_lip = p->top_orow < 1 ? 1 : p->top_orow;
+	p->lower_lip = p->bottom_orow > rows - 2 ? rows - 2 : p->bottom_orow;
+}
+
+/**
+ * Gets the row number of the top or bottom of the opening in the given pipe.
+ *
+ * @param p The pipe obstacle.
+ * @param top Should be 1 for the top, 0 for the bottom.
+ * @param rows Height of the board.
+ *
+ * @return Row number.
+ */
+int get_orow(vpipe p, int top, int rows) {
+	return p.opening_height * (rows - 1) -
+			(top ? 1 : -1) * p.opening_width / 2;
+}
+
+/**
+ * Get Flappy's height along its parabolic arc. sim_step() moves Flappy by
+ * v + GRAV / 2 and then speeds him up by GRAV each frame, which lands on
+ * exactly the same points as the closed form h0 + V0 t + GRAV t^2 / 2.
+ *
+ * @param f Flappy!
+ *
+ * @return height as a row count
+ */
+int get_flappy_position(flappy f) {
+	return f.y / ROW_SCALE;
+}
+
+/**
+ * Returns true if Flappy crashed into a pipe.
+ *
+ * @param h Flappy's row.
+ * @param p The vertical pipe obstacle.
+ *
+ * @return 1 if Flappy crashed, 0 otherwise.
+ */
+int crashed_into_pipe(int h, vpipe p) {
+	if (FLAPPY_COL >= p.center - PIPE_RADIUS - 1 &&
+			FLAPPY_COL <= p.center + PIPE_RADIUS + 1) {
+
+		if (h >= p.top_orow + 1 && h <= p.bottom_orow - 1) {
+			return 0;
+		}
+		else {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Gets the pipe Flappy has to get through next: the leftmost one that
+ * Flappy hasn't cleared yet.
+ *
+ * @param s The game.
+ *
+ * @return The pipe, or the rightmost one if Flappy cleared them all.
+ */
+const vpipe *sim_next_pipe(const game_state *s) {
+	const pipe_pool *pool = &s->pipes;
+	const vpipe *p = &POOL_PIPE(pool, 0);
+	int i;
+
+	for (i = 0; i < pool->count; i++) {
+		p = &POOL_PIPE(pool, i);
+		if (p->center + PIPE_RADIUS + 1 >= FLAPPY_COL)
+			break;
+	}
+	return p;
+}
+
+/**
+ * Returns true if Flappy crashed into any pipe. Pipes are ordered left to
+ * right, so only the one or two pipes around Flappy's column are looked at.
+ *
+ * @param h Flappy's row.
+ * @param pool The pipes in play.
+ * @param shift Columns to the right of their current place to check the
+ * pipes at, e.g. to look at where they were partway through a frame.
+ *
+ * @return 1 if Flappy crashed, 0 otherwise.
+ */
+int crashed_into_pipes(int h, const pipe_pool *pool, int shift) {
+	int i;
+
+	for (i = 0; i < pool->count; i++) {
+		vpipe p = POOL_PIPE(pool, i);
+		p.center += shift;
+		if (p.center - PIPE_RADIUS - 1 > FLAPPY_COL)
+			break; // This and all later pipes are still ahead of Flappy.
+		if (crashed_into_pipe(h, p))
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Returns true if Flappy crashed into a pipe at any point during the last
+ * frame, rather than just where the frame left him. The pipes are stepped
+ * back through the pool->scroll columns they just moved, one column at a
+ * time, with Flappy part of the way along his move from height y0 to where
+ * he is now at each step. Every pipe is checked in every column it passes
+ * through, so none can skip past Flappy, and as the opening is a single run
+ * of rows he can't slip through a lip between two checks either.
+ *
+ * With a scroll of 1 this is the same as crashed_into_pipes() at Flappy's
+ * current row.
+ *
+ * @param f Flappy!
+ * @param y0 Flappy's height at the start of the frame.
+ * @param pool The pipes in play, already moved.
+ *
+ * @return 1 if Flappy crashed, 0 otherwise.
+ */
+int swept_crash(flappy f, int y0, const pipe_pool *pool) {
+	int j, n = pool->scroll;
+
+	for (j = 1; j <= n; j++) {
+		flappy at = f;
+		at.y = y0 + (int64_t) (f.y - y0) * j / n;
+		if (crashed_into_pipes(get_flappy_position(at), pool, n - j))
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * @file
+ *
+ * Headless Flappy Bird engine. Everything in here is pure game logic: no
+ * ncurses, no sleeping and no blocking, so a game can be advanced one frame
+ * at a time with sim_step() as fast as the CPU allows.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+//-------------------------------- Definitions --------------------------------
+
+/**
+ * Represents a vertical pipe through which Flappy The Bird is supposed to fly.
+ */
+typedef struct vpipe {
+
+	/*
+	 * The height of the opening of the pipe as a fraction of the height of the
+	 * console window.
+	 */
+	float opening_height;
+
+	/* Rows in the opening. */
+	int opening_width;
+
+	/*
+	 * Center of the pipe is at this column number (e.g. somewhere in [0, 79]).
+	 * When the center + radius is negative then the pipe's center is rolled
+	 * over to somewhere > the number of columns and the opening height is
+	 * changed.
+	 */
+	int center;
+
+	/*
+	 * Rows of the top and bottom of the opening, i.e. get_orow(p, 1) and
+	 * get_orow(p, 0). Cached along with the rows of the horizontal lips of
+	 * the upper and lower halves of the pipe, which are the openings clamped
+	 * to the board, whenever the opening height changes. The vertical shafts
+	 * run from the ceiling to the upper lip and from the lower lip to the
+	 * floor.
+	 */
+	int top_orow, bottom_orow;
+	int upper_lip, lower_lip;
+} vpipe;
+
+/**
+ * Represents Flappy the Bird. Heights are kept in fixed point, in units of
+ * 1 / ROW_SCALE of a row, so that Flappy moves exactly the same way on
+ * every compiler and platform.
+ */
+typedef struct flappy {
+	/* Height of Flappy the Bird, counting down from the ceiling. */
+	int y;
+
+	/* Velocity per frame; negative is up. */
+	int v;
+} flappy;
+
+/** Capacity of a pipe_pool. Must be a power of two. */
+#define MAX_PIPES 32
+
+/**
+ * Fixed-capacity ring buffer of the pipes in play, ordered left to right.
+ * When the leftmost pipe leaves the screen it is recycled as the new
+ * rightmost pipe, so nothing is ever allocated during play.
+ */
+typedef struct pipe_pool {
+	vpipe ring[MAX_PIPES];
+
+	/* Index in 'ring' of the leftmost pipe. */
+	int head;
+
+	/* Number of pipes in play. */
+	int count;
+
+	/* Columns between the centers of neighboring pipes. */
+	int spacing;
+
+	/* Columns the pipes move left every frame. */
+	int scroll;
+} pipe_pool;
+
+/** Gets the i-th pipe from the left in a pipe_pool. */
+#define POOL_PIPE(pool, i) \
+	((pool)->ring[((pool)->head + (i)) & (MAX_PIPES - 1)])
+
+/** Per-frame decisions accepted by sim_step(). */
+enum sim_input {
+	INPUT_NONE = 0,
+	INPUT_FLAP = 1
+};
+
+/** Everything needed to advance one game by one frame. */
+typedef struct game_state {
+	/* Size of the board, including the floor and ceiling rows. */
+	int rows, cols;
+
+	/* Flappy the Bird. */
+	flappy bird;
+
+	/* The vertical pipe obstacles. */
+	pipe_pool pipes;
+
+	/* Frame number. */
+	int frame;
+
+	/* Number of pipes that have been passed. */
+	int score;
+
+	/* Number of digits in the score. */
+	int sdigs;
+
+	/* Best score so far. */
+	int best_score;
+
+	/* Number of digits in the best score. */
+	int bdigs;
+
+	/* Nonzero once Flappy hit a pipe, the floor or the ceiling. */
+	int dead;
+
+	/*
+	 * State of this game's random number generator, which picks the pipe
+	 * openings. Every game has its own so games on different threads
+	 * neither contend for nor disturb each other's random numbers, and the
+	 * same seed always gives the same pipes on every platform.
+	 */
+	uint64_t rng;
+
+	/* Seed 'rng' started from at the beginning of the current round. */
+	unsigned int seed;
+
+	/*
+	 * Difficulty profile the pipes follow as the score goes up, or NULL for
+	 * the classic game. See sim_set_profile().
+	 */
+	const struct profile *profile;
+} game_state;
+
+//------------------------------ Global Constants -----------------------------
+
+/*
+ * The game's geometry and physics. Normally these are const globals defined
+ * in sim.c, so a custom layout only takes rebuilding sim.o and vecsim.o,
+ * whose lockstep engine has them compiled in; vec_world_init() fails if
+ * the two disagree. A FLAP_FAST build (make flap-fast) turns them into the
+ * literal values instead, which lets the compiler fold them into the
+ * collision checks and unroll the drawing loops.
+ */
+
+/** Fixed-point heights are in units of 1 / ROW_SCALE of a row. */
+#define SIM_ROW_SCALE 1000
+
+/**
+ * Gravitational acceleration constant, in 1 / ROW_SCALE rows per frame per
+ * frame. Must be even.
+ */
+#define SIM_GRAV 50
+
+/** Initial velocity with up arrow press, in 1 / ROW_SCALE rows per frame. */
+#define SIM_V0 (-500)
+
+/** Default number of rows on the board, e.g. for headless games. */
+#define SIM_NUM_ROWS 24
+
+/** Default number of columns on the board, e.g. for headless games. */
+#define SIM_NUM_COLS 80
+
+/** Radius of each vertical pipe. */
+#define SIM_PIPE_RADIUS 3
+
+/** Width of the opening in each pipe. */
+#define SIM_OPENING_WIDTH 7
+
+/** Flappy stays in this column. */
+#define SIM_FLAPPY_COL 10
+
+/** Default number of columns between the centers of neighboring pipes. */
+#define SIM_PIPE_SPACING 44
+
+#ifdef FLAP_FAST
+#define ROW_SCALE SIM_ROW_SCALE
+#define GRAV SIM_GRAV
+#define V0 SIM_V0
+#define NUM_ROWS SIM_NUM_ROWS
+#define NUM_COLS SIM_NUM_COLS
+#define PIPE_RADIUS SIM_PIPE_RADIUS
+#define OPENING_WIDTH SIM_OPENING_WIDTH
+#define FLAPPY_COL SIM_FLAPPY_COL
+#define PIPE_SPACING SIM_PIPE_SPACING
+#else
+extern const int ROW_SCALE;
+extern const int GRAV;
+extern const int V0;
+extern const int NUM_ROWS;
+extern const int NUM_COLS;
+extern const int PIPE_RADIUS;
+extern const int OPENING_WIDTH;
+extern const int FLAPPY_COL;
+extern const int PIPE_SPACING;
+#endif
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Draws the next number from a game's random number generator, which is a
+ * xorshift64* generator: a few shifts and a multiply, no locks and no
+ * global state.
+ *
+ * @param rng Generator state, as set up by sim_seed_rng().
+ *
+ * @return A uniformly distributed 32-bit number.
+ */
+static inline uint32_t sim_rand(uint64_t *rng) {
+	uint64_t x = *rng;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*rng = x;
+	return (x * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+/**
+ * Moves Flappy by one frame, as sim_step() does.
+ *
+ * @param f Flappy!
+ * @param input INPUT_FLAP to give Flappy a boost, INPUT_NONE otherwise.
+ */
+static inline void flappy_move(flappy *f, int input) {
+	if (input == INPUT_FLAP) { // Give Flappy a boost!
+		f->y = f->y / ROW_SCALE * ROW_SCALE;
+		f->v = V0;
+	}
+	else { // Let Flappy fall along his parabola.
+		f->y += f->v + GRAV / 2;
+		f->v += GRAV;
+	}
+}
+
+void sim_init(game_state *s, int rows, int cols, unsigned int seed);
+void sim_set_best(game_state *s, int best);
+void sim_restart(game_state *s);
+void sim_step(game_state *s, int input);
+void sim_set_spacing(game_state *s, int spacing);
+void sim_set_scroll(game_state *s, int scroll);
+void sim_set_profile(game_state *s, const struct profile *p);
+void sim_resize(game_state *s, int rows, int cols);
+void pipe_refresh(game_state *s);
+void pipe_shape(vpipe *p, int rows);
+void sim_seed_rng(uint64_t *rng, uint64_t seed);
+float random_opening_height(uint64_t *rng);
+int get_orow(vpipe p, int top, int rows);
+int get_flappy_position(flappy f);
+const vpipe *sim_next_pipe(const game_state *s);
+int crashed_into_pipe(int h, vpipe p);
+int crashed_into_pipes(int h, const pipe_pool *pool, int shift);
+int swept_crash(flappy f, int y0, const pipe_pool *pool);
+
+#endif
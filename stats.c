@@ -0,0 +1,139 @@
+/**
+ * @file
+ *
+ * Frame timing for --stats. See stats.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+
+//------------------------------ Global Constants -----------------------------
+
+/** The percentiles are recomputed every this many frames. */
+static const int STATS_REFRESH = 16;
+
+//---------------------------------- Functions --------------------------------
+
+static long elapsed_ns(const struct timespec *from, const struct timespec *to) {
+	return (to->tv_sec - from->tv_sec) * 1000000000L +
+			(to->tv_nsec - from->tv_nsec);
+}
+
+static int compare_long(const void *a, const void *b) {
+	long x = *(const long *) a, y = *(const long *) b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * Recomputes the percentiles from the frames in the window.
+ */
+static void refresh_percentiles(frame_stats *st) {
+	long sorted[STATS_WINDOW];
+
+	memcpy(sorted, st->window, st->filled * sizeof(*sorted));
+	qsort(sorted, st->filled, sizeof(*sorted), compare_long);
+	st->p50 = sorted[(st->filled - 1) / 2];
+	st->p99 = sorted[(st->filled - 1) * 99 / 100];
+}
+
+/**
+ * Starts timing frames.
+ *
+ * @param[out] st Timings to set up.
+ * @param csv_path File to log every frame's timings to, or NULL.
+ *
+ * @return 0 on success, -1 with errno set if the log couldn't be created.
+ */
+int stats_init(frame_stats *st, const char *csv_path) {
+	memset(st, 0, sizeof(*st));
+	if (!csv_path)
+		return 0;
+
+	if (!(st->csv = fopen(csv_path, "w")))
+		return -1;
+	fprintf(st->csv, "frame,input_ns,sim_ns,draw_ns,output_ns,total_ns,"
+			"key_lag_ns\n");
+	return 0;
+}
+
+/**
+ * Starts timing a frame, beginning with its input phase.
+ */
+void stats_begin(frame_stats *st) {
+	memset(st->ns, 0, sizeof(st->ns));
+	st->have_key = 0;
+	clock_gettime(CLOCK_MONOTONIC, &st->mark);
+}
+
+/**
+ * Ends a phase of the frame being timed; the next one starts right away.
+ *
+ * @param st
+ * @param phase The phase that just ended, e.g. PHASE_SIM.
+ */
+void stats_lap(frame_stats *st, int phase) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	st->ns[phase] += elapsed_ns(&st->mark, &now);
+	st->mark = now;
+}
+
+/**
+ * Notes when the frame's first key press was read, for the key lag.
+ */
+void stats_key(frame_stats *st, const struct timespec *when) {
+	st->key = *when;
+	st->have_key = 1;
+}
+
+/**
+ * Finishes timing a frame once all of its phases have been lapped.
+ *
+ * @param st
+ * @param frame The game's frame number, for the log.
+ */
+void stats_end(frame_stats *st, int frame) {
+	long total = 0;
+	int i;
+
+	for (i = 0; i < NUM_PHASES; i++)
+		total += st->ns[i];
+
+	st->window[st->next] = total;
+	st->next = (st->next + 1) % STATS_WINDOW;
+	if (st->filled < STATS_WINDOW)
+		st->filled++;
+	if (st->frames++ % STATS_REFRESH == 0)
+		refresh_percentiles(st);
+
+	if (st->csv)
+		fprintf(st->csv, "%d,%ld,%ld,%ld,%ld,%ld,%ld\n", frame,
+				st->ns[PHASE_INPUT], st->ns[PHASE_SIM], st->ns[PHASE_DRAW],
+				st->ns[PHASE_OUTPUT], total,
+				st->have_key ? elapsed_ns(&st->key, &st->mark) : 0);
+}
+
+/**
+ * Summarizes recent frame times in a few words for the status row.
+ */
+void stats_format(const frame_stats *st, char *buf, size_t size) {
+	snprintf(buf, size, " frame p50 %ldus p99 %ldus ", st->p50 / 1000,
+			st->p99 / 1000);
+}
+
+/**
+ * Stops timing frames and finishes the log.
+ *
+ * @return 0 on success, -1 if the log couldn't be written.
+ */
+int stats_close(frame_stats *st) {
+	int status = 0;
+
+	if (st->csv && fclose(st->csv))
+		status = -1;
+	st->csv = NULL;
+	return status;
+}
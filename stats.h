@@ -0,0 +1,69 @@
+/**
+ * @file
+ *
+ * Per-frame timing of the interactive loop, for --stats. Each frame is split
+ * into phases that are timed with the monotonic clock: reading input,
+ * simulating, drawing into the frame buffer and getting the frame onto the
+ * terminal. Frame times are summarized as percentiles over the last few
+ * seconds and can also be logged frame by frame to a CSV file, along with
+ * the key lag: how long after the frame's first key press was read its
+ * output was done.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <time.h>
+
+//-------------------------------- Definitions --------------------------------
+
+/** Phases of a frame, in the order they happen. */
+enum stats_phase {
+	PHASE_INPUT,
+	PHASE_SIM,
+	PHASE_DRAW,
+	PHASE_OUTPUT,
+	NUM_PHASES
+};
+
+/** Number of recent frames the percentiles are taken over. */
+#define STATS_WINDOW 256
+
+/** Timings of the frames so far. */
+typedef struct frame_stats {
+	/* When the phase in progress started. */
+	struct timespec mark;
+
+	/* Time spent in each phase of the frame in progress, in nanoseconds. */
+	long ns[NUM_PHASES];
+
+	/* When the frame's first key was read, if 'have_key' is set. */
+	struct timespec key;
+	int have_key;
+
+	/* Busy time of recent frames in nanoseconds, as a ring buffer. */
+	long window[STATS_WINDOW];
+	int filled, next;
+
+	/* Percentiles of 'window', refreshed every few frames. */
+	long p50, p99;
+
+	/* Frames timed so far. */
+	long frames;
+
+	/* Frame-by-frame log, or NULL. */
+	FILE *csv;
+} frame_stats;
+
+//---------------------------------- Functions --------------------------------
+
+int stats_init(frame_stats *st, const char *csv_path);
+void stats_begin(frame_stats *st);
+void stats_lap(frame_stats *st, int phase);
+void stats_key(frame_stats *st, const struct timespec *when);
+void stats_end(frame_stats *st, int frame);
+void stats_format(const frame_stats *st, char *buf, size_t size);
+int stats_close(frame_stats *st);
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file
+ *
+ * What the game says to players. See text.h.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "text.h"
+
+//-------------------------------- Definitions --------------------------------
+
+/** The languages, as columns of the table. */
+enum language {
+	LANG_EN,
+	LANG_PT_BR,
+	NUM_LANGUAGES
+};
+
+//------------------------------ Global Constants -----------------------------
+
+/**
+ * Every message in every language. The formats of a message must take the
+ * same arguments in every language.
+ */
+static const char *const TEXTS[NUM_LANGUAGES][NUM_TEXTS] = {
+	[LANG_EN] = {
+		[TEXT_SCORE]       = " Score: %d  Best: %d",
+		[TEXT_DIED]        = "Flappy died :-(. <Enter> to flap, 'q' to quit.",
+		[TEXT_PROMPT]      = "Press <up> to flap!",
+		[TEXT_TOO_SMALL]   = "Terminal too small (need %d x %d).",
+		[TEXT_SERVER_FULL] = "Sorry, the server is full."
+	},
+	[LANG_PT_BR] = {
+		[TEXT_SCORE]       = " Pontuacao: %d  Melhor: %d",
+		[TEXT_DIED]        = "Flappy morreu :-(. <Enter> voa, 'q' para sair.",
+		[TEXT_PROMPT]      = "Pressione <up> para voar!",
+		[TEXT_TOO_SMALL]   = "Terminal pequeno (precisa de %d x %d).",
+		[TEXT_SERVER_FULL] = "Desculpe, o servidor esta lotado."
+	}
+};
+
+/**
+ * Names of the languages, as given to text_set_language() or as the start
+ * of a locale name (e.g. pt_BR.UTF-8), longest first among each language's.
+ */
+static const struct {
+	const char *name;
+	enum language lang;
+} NAMES[] = {
+	{ "pt-br", LANG_PT_BR },
+	{ "pt_BR", LANG_PT_BR },
+	{ "pt",    LANG_PT_BR },
+	{ "en",    LANG_EN },
+	{ "C",     LANG_EN },
+	{ "POSIX", LANG_EN }
+};
+
+//------------------------------ Global Variables -----------------------------
+
+/** Messages in the language the game speaks. */
+static const char *const *texts = TEXTS[LANG_EN];
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Gets a message in the language set by text_set_language(), English until
+ * then.
+ */
+const char *text(enum text_id id) {
+	return texts[id];
+}
+
+/**
+ * Looks up a language by name, or by the locale name it starts.
+ *
+ * @return 0 on success, -1 if it isn't one of ours.
+ */
+static int find_language(const char *name, int prefix, enum language *lang) {
+	size_t i, len;
+
+	for (i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); i++) {
+		len = strlen(NAMES[i].name);
+		if (!strncmp(name, NAMES[i].name, len) && (name[len] == '\0' ||
+				(prefix && strchr("_.@-", name[len])))) {
+			*lang = NAMES[i].lang;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Picks the language the game speaks.
+ *
+ * @param name "en" or "pt-br", or NULL to follow the locale the environment
+ * asks for (LC_ALL, LC_MESSAGES or LANG), falling back on English.
+ *
+ * @return 0 on success, -1 with errno set to EINVAL if the game doesn't
+ * speak the language.
+ */
+int text_set_language(const char *name) {
+	static const char *const VARS[] = { "LC_ALL", "LC_MESSAGES", "LANG" };
+	enum language lang = LANG_EN;
+	size_t i;
+
+	if (name) {
+		if (find_language(name, 0, &lang)) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	else {
+		// The first variable that's set decides, as for setlocale().
+		for (i = 0; i < sizeof(VARS) / sizeof(VARS[0]); i++) {
+			if ((name = getenv(VARS[i])) && *name) {
+				find_language(name, 1, &lang);
+				break;
+			}
+		}
+	}
+	texts = TEXTS[lang];
+	return 0;
+}
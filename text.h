@@ -0,0 +1,43 @@
+/**
+ * @file
+ *
+ * What the game says to players, in each language it speaks. Everything a
+ * player reads goes through text(), so a translation is one more column in
+ * the table in text.c rather than another copy of the game.
+ *
+ * Translations are plain ASCII: cells hold one byte each, and the bytes
+ * from GLYPH_FIRST on are block glyphs (see cellbuf.h), not UTF-8. Messages
+ * are drawn on the smallest board too, so none may be wider than MIN_COLS.
+ */
+
+#ifndef TEXT_H
+#define TEXT_H
+
+//-------------------------------- Definitions --------------------------------
+
+/** The messages, by what they're for. */
+enum text_id {
+	/* Score line, from the score and the best score. */
+	TEXT_SCORE,
+
+	/* The failure screen's message. */
+	TEXT_DIED,
+
+	/* The splash screen's prompt. */
+	TEXT_PROMPT,
+
+	/* Asks for a bigger terminal, from the smallest width and height. */
+	TEXT_TOO_SMALL,
+
+	/* Turns a player away from a full server. */
+	TEXT_SERVER_FULL,
+
+	NUM_TEXTS
+};
+
+//---------------------------------- Functions --------------------------------
+
+const char *text(enum text_id id);
+int text_set_language(const char *name);
+
+#endif
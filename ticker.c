@@ -0,0 +1,146 @@
+/**
+ * @file
+ *
+ * Fixed-timestep frame scheduler. See ticker.h.
+ */
+
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "ticker.h"
+
+//------------------------------ Global Constants -----------------------------
+
+static const long NSEC_PER_SEC = 1000000000L;
+
+/** Default ceiling on the number of ticks simulated without a redraw. */
+static const int MAX_CATCHUP_TICKS = 5;
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Adds the given number of nanoseconds to a timespec.
+ */
+static void timespec_add_ns(struct timespec *ts, long long ns) {
+	ns += ts->tv_nsec;
+	ts->tv_sec += ns / NSEC_PER_SEC;
+	ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+/**
+ * Gets a - b in nanoseconds.
+ */
+static long long timespec_diff_ns(const struct timespec *a,
+		const struct timespec *b) {
+	return (long long) (a->tv_sec - b->tv_sec) * NSEC_PER_SEC +
+			(a->tv_nsec - b->tv_nsec);
+}
+
+/**
+ * (Re)starts the schedule so that the first tick is due one period from now.
+ * Call this again after anything that blocked the loop for a while, like a
+ * menu waiting on the user.
+ *
+ * @param[out] tk Scheduler to start.
+ * @param fps Ticks per second.
+ */
+void ticker_start(ticker *tk, float fps) {
+	tk->period_ns = NSEC_PER_SEC / fps;
+	tk->max_catchup = MAX_CATCHUP_TICKS;
+	tk->timer_fd = -1;
+	clock_gettime(CLOCK_MONOTONIC, &tk->next);
+	timespec_add_ns(&tk->next, tk->period_ns);
+}
+
+/**
+ * Counts the ticks that are due now that the next deadline has passed, and
+ * moves the deadline past them.
+ */
+static int ticks_due(ticker *tk) {
+	struct timespec now;
+	long long late;
+	int ticks;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	late = timespec_diff_ns(&now, &tk->next);
+	ticks = 1 + (late > 0 ? late / tk->period_ns : 0);
+
+	if (ticks > tk->max_catchup) {
+		// Too far behind to catch up; resynchronize to the clock.
+		tk->next = now;
+		timespec_add_ns(&tk->next, tk->period_ns);
+		return tk->max_catchup;
+	}
+
+	timespec_add_ns(&tk->next, (long long) ticks * tk->period_ns);
+	return ticks;
+}
+
+/**
+ * Sets up the timer ticker_poll() waits on. Call after ticker_start().
+ *
+ * @return 0 on success, -1 with errno set on error.
+ */
+int ticker_open_timer(ticker *tk) {
+	tk->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	return tk->timer_fd < 0 ? -1 : 0;
+}
+
+/**
+ * Blocks until either the next tick is due or there is input to read on a
+ * file descriptor, whichever comes first, without using any CPU until
+ * then. Signals (e.g. SIGWINCH) wake it up like input does.
+ *
+ * @param tk Scheduler to wait on; ticker_open_timer() must have been called.
+ * @param fd File descriptor to wait for input on.
+ * @param idle Nonzero if no ticks are needed until there's input. Then
+ *        only the input is waited for, and the schedule restarts from the
+ *        moment it arrives, as if the ticker had been paused.
+ *
+ * @return Number of ticks to simulate, or 0 if it was input that woke the
+ * caller up. Normally a tick makes 1. If the caller overran one or more
+ * deadlines the missed ticks are counted as well, up to tk->max_catchup, so
+ * the game keeps running at the same speed and the caller can simulate them
+ * all and render only the last one.
+ */
+int ticker_poll(ticker *tk, int fd, int idle) {
+	struct pollfd fds[2];
+	struct itimerspec when;
+	uint64_t expirations;
+
+	fds[0].fd = fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = tk->timer_fd;
+	fds[1].events = POLLIN;
+
+	if (!idle) {
+		memset(&when, 0, sizeof(when));
+		when.it_value = tk->next;
+		timerfd_settime(tk->timer_fd, TFD_TIMER_ABSTIME, &when, NULL);
+	}
+
+	if (poll(fds, idle ? 1 : 2, -1) > 0 && !idle &&
+			(fds[1].revents & POLLIN)) {
+		// Only clears the timer: the deadline says how many ticks are due.
+		read(tk->timer_fd, &expirations, sizeof(expirations));
+		return ticks_due(tk);
+	}
+
+	if (idle) {
+		clock_gettime(CLOCK_MONOTONIC, &tk->next);
+		timespec_add_ns(&tk->next, tk->period_ns);
+	}
+	return 0;
+}
+
+/**
+ * Releases the timer of ticker_open_timer(), if any.
+ */
+void ticker_close(ticker *tk) {
+	if (tk->timer_fd >= 0)
+		close(tk->timer_fd);
+	tk->timer_fd = -1;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file
+ *
+ * Fixed-timestep frame scheduler. Ticks are laid out on absolute deadlines
+ * of the monotonic clock, so time spent simulating and drawing a frame never
+ * adds up into drift the way a sleep after every frame does.
+ *
+ * The loop blocks in ticker_poll(), which wakes up on whichever comes
+ * first, the next tick or input, and can go without ticks altogether while
+ * there is nothing to animate.
+ */
+
+#ifndef TICKER_H
+#define TICKER_H
+
+#include <time.h>
+
+/** Paces a loop at a fixed number of ticks per second. */
+typedef struct ticker {
+	/* Absolute CLOCK_MONOTONIC deadline of the next tick. */
+	struct timespec next;
+
+	/* Length of one tick in nanoseconds. */
+	long period_ns;
+
+	/*
+	 * Most ticks ticker_poll() reports at once. If the loop falls further
+	 * behind than this (e.g. the process was stopped) the schedule is
+	 * restarted from now instead of fast-forwarding the game.
+	 */
+	int max_catchup;
+
+	/* Timer for ticker_poll(), or -1 until ticker_open_timer(). */
+	int timer_fd;
+} ticker;
+
+void ticker_start(ticker *tk, float fps);
+int ticker_open_timer(ticker *tk);
+int ticker_poll(ticker *tk, int fd, int idle);
+void ticker_close(ticker *tk);
+
+#endif
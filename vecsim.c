@@ -0,0 +1,325 @@
+/**
+ * @file
+ *
+ * Lockstep structure-of-arrays game engine. See vecsim.h.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vecsim.h"
+
+//------------------------------ Global Constants -----------------------------
+
+/** Per-game arrays are aligned to and padded out to this many bytes. */
+static const size_t LANE_ALIGN = 64;
+
+//---------------------------------- Functions --------------------------------
+
+/**
+ * Checks that sim.c plays with the physics and geometry this file is
+ * compiled with, which it does unless sim.o was rebuilt with a custom
+ * layout and vecsim.o wasn't.
+ */
+static int same_geometry(void) {
+	return ROW_SCALE == SIM_ROW_SCALE && GRAV == SIM_GRAV && V0 == SIM_V0 &&
+			PIPE_RADIUS == SIM_PIPE_RADIUS &&
+			OPENING_WIDTH == SIM_OPENING_WIDTH && FLAPPY_COL == SIM_FLAPPY_COL;
+}
+
+/*
+ * From here on the physics and geometry are literals even when they are
+ * const globals in sim.c (see sim.h): the lockstep loops only vectorize if
+ * they are, as a division by a value loaded at run time keeps GCC from
+ * vectorizing. vec_world_init() refuses to run if sim.c's values differ.
+ */
+#ifndef FLAP_FAST
+#define ROW_SCALE SIM_ROW_SCALE
+#define GRAV SIM_GRAV
+#define V0 SIM_V0
+#define PIPE_RADIUS SIM_PIPE_RADIUS
+#define OPENING_WIDTH SIM_OPENING_WIDTH
+#define FLAPPY_COL SIM_FLAPPY_COL
+#endif
+
+/**
+ * Allocates a zeroed, SIMD-aligned array of 'count' elements.
+ */
+static void *alloc_lanes(size_t count, size_t size) {
+	size_t bytes = (count * size + LANE_ALIGN - 1) / LANE_ALIGN * LANE_ALIGN;
+	void *p = aligned_alloc(LANE_ALIGN, bytes ? bytes : LANE_ALIGN);
+	if (p)
+		memset(p, 0, bytes);
+	return p;
+}
+
+/**
+ * Sets up a world of 'n' games on the same board as 'like'. All games start
+ * out dead; fill them in with vec_world_load().
+ *
+ * @param[out] w World to initialize.
+ * @param n Number of games.
+ * @param like Game whose board size and pipe spacing all games share.
+ *
+ * @return 0 on success, -1 if out of memory, or with errno set to EINVAL if
+ * sim.o was built with another layout than vecsim.o (see sim.h).
+ */
+int vec_world_init(vec_world *w, int n, const game_state *like) {
+	size_t slots;
+
+	// Playing on with other physics than sim_step() would silently change
+	// every result; a debug build stops right here.
+	assert(same_geometry());
+	if (!same_geometry()) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	w->n = n;
+	w->npipes = like->pipes.count;
+	w->rows = like->rows;
+	w->cols = like->cols;
+	w->spacing = like->pipes.spacing;
+	slots = (size_t) w->npipes * n;
+
+	w->y = alloc_lanes(n, sizeof(int));
+	w->v = alloc_lanes(n, sizeof(int));
+	w->frame = alloc_lanes(n, sizeof(int));
+	w->score = alloc_lanes(n, sizeof(int));
+	w->tail = alloc_lanes(n, sizeof(int));
+	w->dead = alloc_lanes(n, 1);
+	w->rng = alloc_lanes(n, sizeof(uint64_t));
+	w->pos = alloc_lanes(n, sizeof(int));
+	w->crash = alloc_lanes(n, sizeof(int));
+	w->center = alloc_lanes(slots, sizeof(int));
+	w->opening_height = alloc_lanes(slots, sizeof(float));
+	w->top_orow = alloc_lanes(slots, sizeof(int));
+	w->bottom_orow = alloc_lanes(slots, sizeof(int));
+
+	if (!w->y || !w->v || !w->frame || !w->score || !w->tail || !w->dead ||
+			!w->rng || !w->pos || !w->crash || !w->center ||
+			!w->opening_height || !w->top_orow || !w->bottom_orow) {
+		vec_world_free(w);
+		return -1;
+	}
+	memset(w->dead, 1, n);
+	return 0;
+}
+
+/**
+ * Releases the arrays of a world.
+ */
+void vec_world_free(vec_world *w) {
+	free(w->y);
+	free(w->v);
+	free(w->frame);
+	free(w->score);
+	free(w->tail);
+	free(w->dead);
+	free(w->rng);
+	free(w->pos);
+	free(w->crash);
+	free(w->center);
+	free(w->opening_height);
+	free(w->top_orow);
+	free(w->bottom_orow);
+	memset(w, 0, sizeof(*w));
+}
+
+/**
+ * Copies a game into slot 'i' of the world, e.g. to start or restart it.
+ * The game must be on the world's board.
+ */
+void vec_world_load(vec_world *w, int i, const game_state *s) {
+	int k, n = w->n;
+
+	// Pipes always move one column per frame and keep the classic openings
+	// here.
+	assert(s->rows == w->rows && s->cols == w->cols &&
+			s->pipes.spacing == w->spacing && s->pipes.count == w->npipes &&
+			s->pipes.scroll == 1 && !s->profile);
+
+	w->y[i] = s->bird.y;
+	w->v[i] = s->bird.v;
+	w->frame[i] = s->frame;
+	w->score[i] = s->score;
+	w->dead[i] = s->dead;
+	w->rng[i] = s->rng;
+	w->tail[i] = w->npipes - 1;
+	for (k = 0; k < w->npipes; k++) {
+		const vpipe *p = &POOL_PIPE(&s->pipes, k);
+		w->center[k * n + i] = p->center;
+		w->opening_height[k * n + i] = p->opening_height;
+		w->top_orow[k * n + i] = p->top_orow;
+		w->bottom_orow[k * n + i] = p->bottom_orow;
+	}
+}
+
+/**
+ * Copies game 'i' of the world back out, e.g. to draw it or compare it with
+ * a game run through sim_step(). The best score is left alone.
+ */
+void vec_world_store(const vec_world *w, int i, game_state *s) {
+	int k, slot, n = w->n;
+
+	s->bird.y = w->y[i];
+	s->bird.v = w->v[i];
+	s->frame = w->frame[i];
+	s->score = w->score[i];
+	s->sdigs = 1 + (s->score > 9) + (s->score > 99);
+	s->dead = w->dead[i];
+	s->rng = w->rng[i];
+
+	// The slot after the tail holds the leftmost pipe.
+	s->pipes.head = 0;
+	s->pipes.count = w->npipes;
+	for (k = 0; k < w->npipes; k++) {
+		vpipe *p = &POOL_PIPE(&s->pipes, k);
+		slot = (w->tail[i] + 1 + k) % w->npipes;
+		p->center = w->center[slot * n + i];
+		p->opening_height = w->opening_height[slot * n + i];
+		p->opening_width = OPENING_WIDTH;
+		pipe_shape(p, w->rows);
+	}
+}
+
+/**
+ * Recycles the leftmost pipe of game 'i' as its rightmost pipe for as long
+ * as the leftmost pipe is off the left edge. Same as the wrapping part of
+ * pipe_refresh(). This happens about once every 'spacing' ticks per game, so
+ * it is done one game at a time.
+ */
+static void wrap_pipes(vec_world *w, int i) {
+	int n = w->n;
+
+	for (;;) {
+		int head = (w->tail[i] + 1) % w->npipes;
+		int prev = w->center[w->tail[i] * n + i];
+		vpipe p;
+
+		if (w->center[head * n + i] + PIPE_RADIUS >= 0)
+			break;
+
+		// With a single pipe the pipe to follow is the one that just left,
+		// so like append_pipe() it comes back just out of view.
+		p.center = w->npipes > 1 ? prev + w->spacing : 0;
+		if (p.center < w->cols + PIPE_RADIUS)
+			p.center = w->cols + PIPE_RADIUS;
+		p.opening_height = random_opening_height(&w->rng[i]);
+		p.opening_width = OPENING_WIDTH;
+		pipe_shape(&p, w->rows);
+
+		w->center[head * n + i] = p.center;
+		w->opening_height[head * n + i] = p.opening_height;
+		w->top_orow[head * n + i] = p.top_orow;
+		w->bottom_orow[head * n + i] = p.bottom_orow;
+		w->tail[i] = head;
+		w->score[i]++;
+	}
+}
+
+/**
+ * Advances every live game by one frame, exactly like sim_step() would. The
+ * loops over games are branch-free so the compiler can vectorize them.
+ *
+ * @param w World to advance.
+ * @param flap One entry per game: nonzero to flap, zero to let Flappy fall.
+ *
+ * @return Number of games still alive.
+ */
+int vec_world_step(vec_world *w, const unsigned char *restrict flap) {
+	const int n = w->n, rows = w->rows;
+	int *restrict y = w->y, *restrict v = w->v;
+	int *restrict pos = w->pos, *restrict crash = w->crash;
+	int *restrict frame = w->frame;
+	unsigned char *restrict dead = w->dead;
+	int i, k, alive = 0;
+
+	// Apply this frame's input to Flappy.
+	for (i = 0; i < n; i++) {
+		int live = !dead[i];
+		int up = live & (flap[i] != 0);
+		int fall = live & !up;
+		int row = y[i] / ROW_SCALE * ROW_SCALE;
+		y[i] += up * (row - y[i]) + fall * (v[i] + GRAV / 2);
+		v[i] += up * (V0 - v[i]) + fall * GRAV;
+	}
+
+	// Wrap pipes that went off the left edge, then scroll all of them.
+	for (i = 0; i < n; i++)
+		if (!dead[i])
+			wrap_pipes(w, i);
+	for (k = 0; k < w->npipes; k++) {
+		int *restrict center = w->center + (size_t) k * n;
+		for (i = 0; i < n; i++)
+			center[i] -= !dead[i];
+	}
+
+	// Flappy crashed into the ceiling, the floor or a pipe.
+	for (i = 0; i < n; i++) {
+		pos[i] = y[i] / ROW_SCALE;
+		crash[i] = (pos[i] <= 0) | (pos[i] >= rows - 1);
+	}
+	for (k = 0; k < w->npipes; k++) {
+		const int *restrict center = w->center + (size_t) k * n;
+		const int *restrict top = w->top_orow + (size_t) k * n;
+		const int *restrict bottom = w->bottom_orow + (size_t) k * n;
+		for (i = 0; i < n; i++) {
+			int in_col = (FLAPPY_COL >= center[i] - PIPE_RADIUS - 1) &
+					(FLAPPY_COL <= center[i] + PIPE_RADIUS + 1);
+			int outside = (pos[i] < top[i] + 1) | (pos[i] > bottom[i] - 1);
+			crash[i] |= in_col & outside;
+		}
+	}
+	for (i = 0; i < n; i++) {
+		int live = !dead[i] & !crash[i];
+		dead[i] = !live;
+		frame[i] += live;
+		alive += live;
+	}
+
+	return alive;
+}
+
+/**
+ * Decides every live game's input for the next frame the way batch_policy()
+ * would: flap when Flappy has sunk below the middle of the next pipe's
+ * opening and hasn't just flapped.
+ *
+ * @param w World whose games to decide for. Its scratch space is used.
+ * @param[out] flap One entry per game: nonzero to flap, zero to let Flappy
+ * fall.
+ */
+void vec_world_policy(vec_world *w, unsigned char *restrict flap) {
+	const int n = w->n;
+	const int *restrict y = w->y, *restrict v = w->v;
+	const unsigned char *restrict dead = w->dead;
+	int *restrict next = w->crash, *restrict mid = w->pos;
+	int i, k;
+
+	// A game's pipes are spaced out left to right, so the next pipe is the
+	// one with the smallest center that Flappy hasn't cleared, or else the
+	// rightmost pipe.
+	for (i = 0; i < n; i++) {
+		int tail = w->tail[i] * n + i;
+		next[i] = INT_MAX;
+		mid[i] = (w->top_orow[tail] + w->bottom_orow[tail]) / 2;
+	}
+	for (k = 0; k < w->npipes; k++) {
+		const int *restrict center = w->center + (size_t) k * n;
+		const int *restrict top = w->top_orow + (size_t) k * n;
+		const int *restrict bottom = w->bottom_orow + (size_t) k * n;
+		for (i = 0; i < n; i++) {
+			int take = (center[i] + PIPE_RADIUS + 1 >= FLAPPY_COL) &
+					(center[i] < next[i]);
+			next[i] = take ? center[i] : next[i];
+			mid[i] = take ? (top[i] + bottom[i]) / 2 : mid[i];
+		}
+	}
+	for (i = 0; i < n; i++)
+		flap[i] = !dead[i] & (v[i] > V0 + 3 * GRAV) &
+				(y[i] / ROW_SCALE > mid[i]);
+}
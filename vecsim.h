@@ -0,0 +1,62 @@
+/**
+ * @file
+ *
+ * Runs many independent games in lockstep for agent evaluation. The games
+ * are stored as a structure of arrays (one array per field, one element per
+ * game), so that Flappy's parabola and the pipe collision checks can be
+ * evaluated with SIMD across hundreds of games per tick. Physics and
+ * geometry come from sim.h and a step here gives exactly the same result as
+ * sim_step() on each game.
+ */
+
+#ifndef VECSIM_H
+#define VECSIM_H
+
+#include "sim.h"
+
+/**
+ * N games on boards of the same size and pipe spacing. Pipe arrays are
+ * slot-major: the field of pipe slot k in game i is at [k * n + i]. Within a
+ * game the slots are not ordered by position; 'tail' remembers which slot
+ * holds the rightmost pipe.
+ */
+typedef struct vec_world {
+	/* Number of games. */
+	int n;
+
+	/* Pipe slots per game. */
+	int npipes;
+
+	/* Board shared by all games. */
+	int rows, cols, spacing;
+
+	/* Flappy: fields of the flappy struct, one per game. */
+	int *y;
+	int *v;
+
+	/* Bookkeeping, one per game. */
+	int *frame;
+	int *score;
+	int *tail;
+	unsigned char *dead;
+	uint64_t *rng;
+
+	/* Scratch space for vec_world_step(), one per game. */
+	int *pos;
+	int *crash;
+
+	/* Pipes: fields of the vpipe struct, npipes * n of each. */
+	int *center;
+	float *opening_height;
+	int *top_orow;
+	int *bottom_orow;
+} vec_world;
+
+int vec_world_init(vec_world *w, int n, const game_state *like);
+void vec_world_free(vec_world *w);
+void vec_world_load(vec_world *w, int i, const game_state *s);
+void vec_world_store(const vec_world *w, int i, game_state *s);
+int vec_world_step(vec_world *w, const unsigned char *flap);
+void vec_world_policy(vec_world *w, unsigned char *flap);
+
+#endif